@@ -0,0 +1,77 @@
+/**
+ *
+ * @file bench_hal.h
+ * @version 1.1.0
+ *
+ * ------------------------------
+ *
+ * @author https://github.com/AJ747
+ * @date Jul 12, 2025
+ *
+ * ------------------------------
+ *
+ * @brief Stub pin layer for host debounce benchmark, pins are plain variables
+ *
+ */
+
+#ifndef TOOLS_DEBOUNCE_BENCH_BENCH_HAL_H_
+#define TOOLS_DEBOUNCE_BENCH_BENCH_HAL_H_
+
+
+
+//---------------------------//
+// Include begin
+//---------------------------//
+#include <stdint.h>
+//---------------------------//
+// Include end
+//---------------------------//
+
+
+
+//---------------------------//
+// Define begin
+//---------------------------//
+// Handler period, swept by sweep.sh
+#ifndef TIMx_PERIOD_MS
+#define TIMx_PERIOD_MS 10
+#endif
+
+#define SW0_PIN 0
+#define SW1_PIN 1
+#define BTN0_PIN 2
+#define BTN1_PIN 3
+#define BTN2_PIN 4
+#define LED0_PIN 5
+#define LED1_PIN 6
+#define LED2_PIN 7
+#define BENCH_PINS 8
+
+#define INPUT_PULL_UP 0
+#define OUTPUT 1
+
+#define PIN_CONFIG(pin, mode) ((void) (pin), (void) (mode))
+#define PIN_READ(pin) (bench_pin[(pin)])
+#define PIN_HIGH(pin) (bench_pin[(pin)] = 1)
+#define PIN_LOW(pin) (bench_pin[(pin)] = 0)
+#define PIN_TOGGLE(pin) (bench_pin[(pin)] ^= 1)
+
+#define TIMESTAMP_US() (bench_now_us)
+//---------------------------//
+// Define end
+//---------------------------//
+
+
+
+//---------------------------//
+// Variable begin
+//---------------------------//
+extern volatile uint8_t bench_pin[BENCH_PINS];
+extern volatile uint32_t bench_now_us;
+//---------------------------//
+// Variable end
+//---------------------------//
+
+
+
+#endif /* TOOLS_DEBOUNCE_BENCH_BENCH_HAL_H_ */
@@ -0,0 +1,404 @@
+/**
+ *
+ * @file debounce_bench.c
+ * @version 1.1.0
+ *
+ * ------------------------------
+ *
+ * @author https://github.com/AJ747
+ * @date Jul 12, 2025
+ *
+ * ------------------------------
+ *
+ * @brief Host benchmark, feeds synthetic contact bounce through the handler and reports
+ * press latency, missed and false presses of current USER_IO_HANDLER_PERIOD_MS and BTN_DEBOUNCE_TRESHOLD_MS,
+ * or BTN_DEBOUNCE_PRESS_MS and BTN_DEBOUNCE_RELEASE_MS with BTN_DEBOUNCE_INTEGRATOR_USE
+ *
+ * Build from repository root, or run sweep.sh to compare settings:
+ * gcc -std=c99 -O2 -Iuser_io/inc -include tools/debounce_bench/bench_hal.h \
+ *     user_io/src/user_io.c user_io/src/user_io_driver.c tools/debounce_bench/debounce_bench.c -o debounce_bench
+ *
+ * Usage: debounce_bench [bounce_ms press_ms glitches_per_1000_ms]
+ * Without arguments a set of scenarios is run.
+ *
+ */
+
+
+
+//---------------------------//
+// Include begin
+//---------------------------//
+#include <stdio.h>
+#include <stdlib.h>
+#include "user_io.h"
+//---------------------------//
+// Include end
+//---------------------------//
+
+
+
+//---------------------------//
+// Define begin
+//---------------------------//
+#define BENCH_PRESSES 2000
+#define BENCH_PERIOD_US (USER_IO_HANDLER_PERIOD_MS * 1000U)
+#define BENCH_GAP_MIN_US 100000U // Time released between presses
+#define BENCH_GAP_RANGE_US 200000U
+#define BENCH_EDGE_MIN_US 50U // Time between bounce edges
+#define BENCH_EDGE_RANGE_US 400U
+#define BENCH_GLITCH_MIN_US 100U // Length of a glitch to the other level
+#define BENCH_GLITCH_RANGE_US 900U
+
+// Debounce settings printed, press must register within longest one after release settled
+#ifdef BTN_DEBOUNCE_INTEGRATOR_USE
+#define BENCH_PRESS_MS BTN_DEBOUNCE_PRESS_MS
+#define BENCH_RELEASE_MS BTN_DEBOUNCE_RELEASE_MS
+#else
+#define BENCH_PRESS_MS BTN_DEBOUNCE_TRESHOLD_MS
+#define BENCH_RELEASE_MS BTN_DEBOUNCE_TRESHOLD_MS
+#endif
+#define BENCH_WINDOW_MS ((BENCH_PRESS_MS > BENCH_RELEASE_MS)? BENCH_PRESS_MS : BENCH_RELEASE_MS)
+//---------------------------//
+// Define end
+//---------------------------//
+
+
+
+//---------------------------//
+// Typedef begin
+//---------------------------//
+struct bench_scenario {
+	uint32_t bounce_ms;		// Longest bounce after each edge
+	uint32_t press_ms;		// Mean press length, each press is 50 % to 150 % of it
+	uint32_t glitches;		// Glitches per 1000 ms of steady contact
+};
+
+struct bench_result {
+	uint32_t missed;		// Presses without a click before release settled plus a debounce window
+	uint32_t extra;			// Clicks that belong to no press, or after the first of a press
+	uint32_t latency_us[BENCH_PRESSES]; // First edge to click, per press with a click
+	uint32_t latencies;
+};
+//---------------------------//
+// Typedef end
+//---------------------------//
+
+
+
+//---------------------------//
+// Prototypes begin
+//---------------------------//
+static uint32_t bench_rand(uint32_t range);
+static void bench_advance(uint32_t until_us);
+static void bench_set(bool pressed);
+static void bench_bounce(bool pressed, uint32_t bounce_us);
+static void bench_steady(bool pressed, uint32_t until_us, uint32_t glitches);
+static void bench_press_end(void);
+static void bench_run(const struct bench_scenario *scenario);
+static int bench_compare(const void *a, const void *b);
+static uint32_t bench_percentile(uint32_t percent);
+static void bench_print(void);
+//---------------------------//
+// Prototypes end
+//---------------------------//
+
+
+
+//---------------------------//
+// Variable begin
+//---------------------------//
+volatile uint8_t bench_pin[BENCH_PINS];
+volatile uint32_t bench_now_us = 0;
+
+static const struct bench_scenario bench_scenarios[] = {
+	{1, 100, 0},
+	{5, 100, 0},
+	{10, 100, 0},
+	{5, 40, 0},
+	{5, 20, 0},
+	{5, 100, 5},
+	{10, 100, 20},
+};
+
+static struct bench_result result;
+static uint32_t bench_seed = 1;
+static uint32_t bench_tick_us = 0;
+static uint32_t bench_press_start_us = 0;
+static uint32_t bench_press_clicks = 0;
+static uint32_t bench_press_deadline_us = 0;
+static bool bench_in_press = false;
+static bool bench_released = false;
+//---------------------------//
+// Variable end
+//---------------------------//
+
+
+
+/**
+ * @fn int main(int, char**)
+ * @brief Runs scenario given as arguments, or all built-in scenarios with a header
+ *
+ * @param argc (int)
+ * @param argv (char**)
+ * @return (int)
+ */
+int main(int argc, char **argv) {
+	if (argc == 4) {
+		struct bench_scenario scenario = {
+			(uint32_t) strtoul(argv[1], 0, 10), (uint32_t) strtoul(argv[2], 0, 10), (uint32_t) strtoul(argv[3], 0, 10)
+		};
+
+		bench_run(&scenario);
+		bench_print();
+		return 0;
+	}
+
+	if (argc != 1) {
+		fprintf(stderr, "usage: %s [bounce_ms press_ms glitches_per_1000_ms]\n", argv[0]);
+		return 1;
+	}
+
+	for (size_t i = 0; i < (sizeof(bench_scenarios) / sizeof(bench_scenarios[0])); i++) {
+		printf("bounce %lu ms, press %lu ms, %lu glitches per 1000 ms\n", (unsigned long) bench_scenarios[i].bounce_ms,
+				(unsigned long) bench_scenarios[i].press_ms, (unsigned long) bench_scenarios[i].glitches);
+		printf("period  press   release | missed %%  false %% | latency us  p50     p90     p99     max\n");
+		bench_run(&bench_scenarios[i]);
+		bench_print();
+		printf("\n");
+	}
+
+	return 0;
+}
+
+
+
+/**
+ * @fn uint32_t bench_rand(uint32_t)
+ * @brief Returns pseudo random number below range, same sequence every run
+ *
+ * @param range (uint32_t)
+ * @return (uint32_t)
+ */
+static uint32_t bench_rand(uint32_t range) {
+	bench_seed = (bench_seed * 1103515245U) + 12345U;
+
+	return (bench_seed >> 8) % range;
+}
+
+
+
+/**
+ * @fn void bench_advance(uint32_t)
+ * @brief Calls handler for every tick up to until_us and collects clicks
+ *
+ * @param until_us (uint32_t) simulated time to advance to
+ */
+static void bench_advance(uint32_t until_us) {
+	while (bench_tick_us <= until_us) {
+		bench_now_us = bench_tick_us;
+		user_io_irq_handler();
+
+		// Press is over once release had a full debounce window and a tick to register
+		if (bench_in_press && bench_released && (bench_tick_us > bench_press_deadline_us)) {
+			bench_press_end();
+		}
+
+		if (btn_click(BTN0)) {
+			if (!bench_in_press) {
+				result.extra++;
+			} else if (!bench_press_clicks++) {
+				result.latency_us[result.latencies++] = bench_tick_us - bench_press_start_us;
+			} else {
+				result.extra++;
+			}
+		}
+		bench_tick_us += BENCH_PERIOD_US;
+	}
+	bench_now_us = until_us;
+}
+
+
+
+/**
+ * @fn void bench_set(bool)
+ * @brief Drives button line, active low
+ *
+ * @param pressed (bool)
+ */
+static void bench_set(bool pressed) {
+	uint8_t level = pressed? 0 : 1;
+
+	if (bench_pin[BTN0_PIN] == level) {
+		return;
+	}
+	bench_pin[BTN0_PIN] = level;
+
+#ifdef BTN_TIMESTAMPS_EXTI_USE
+	btn_edge_irq(BTN0);
+#endif
+}
+
+
+
+/**
+ * @fn void bench_bounce(bool, uint32_t)
+ * @brief Moves line to new level, toggling at random for up to bounce_us first
+ *
+ * @param pressed (bool) level the contact settles at
+ * @param bounce_us (uint32_t) longest bounce
+ */
+static void bench_bounce(bool pressed, uint32_t bounce_us) {
+	uint32_t end_us = bench_now_us + bench_rand(bounce_us + 1U);
+	bool level = pressed;
+
+	bench_set(level);
+
+	while (1) {
+		uint32_t next_us = bench_now_us + BENCH_EDGE_MIN_US + bench_rand(BENCH_EDGE_RANGE_US);
+
+		if (next_us > end_us) {
+			break;
+		}
+		bench_advance(next_us);
+		level = !level;
+		bench_set(level);
+	}
+
+	bench_advance(end_us);
+	bench_set(pressed);
+}
+
+
+
+/**
+ * @fn void bench_steady(bool, uint32_t, uint32_t)
+ * @brief Holds line at level until until_us, with short glitches to the other level
+ *
+ * @param pressed (bool) level held
+ * @param until_us (uint32_t) end of hold
+ * @param glitches (uint32_t) glitches per 1000 ms
+ */
+static void bench_steady(bool pressed, uint32_t until_us, uint32_t glitches) {
+	while (bench_now_us < until_us) {
+		bench_advance(bench_now_us + 1000U);
+
+		if (bench_rand(1000) < glitches) {
+			bench_set(!pressed);
+			bench_advance(bench_now_us + BENCH_GLITCH_MIN_US + bench_rand(BENCH_GLITCH_RANGE_US));
+			bench_set(pressed);
+		}
+	}
+}
+
+
+
+/**
+ * @fn void bench_press_end(void)
+ * @brief Closes counting of clicks of last press, later clicks are false presses
+ *
+ */
+static void bench_press_end(void) {
+	if (bench_in_press && !bench_press_clicks) {
+		result.missed++;
+	}
+	bench_in_press = false;
+}
+
+
+
+/**
+ * @fn void bench_run(const struct bench_scenario*)
+ * @brief Presses and releases BTN0 BENCH_PRESSES times from a fresh state
+ *
+ * @param scenario (const struct bench_scenario*)
+ */
+static void bench_run(const struct bench_scenario *scenario) {
+	uint32_t bounce_us = scenario->bounce_ms * 1000U;
+	uint32_t press_us = scenario->press_ms * 1000U;
+
+	for (uint8_t pin = 0; pin < BENCH_PINS; pin++) {
+		bench_pin[pin] = 1;
+	}
+	bench_seed = 1;
+	bench_now_us = 0;
+	bench_tick_us = BENCH_PERIOD_US;
+	bench_in_press = false;
+	bench_released = false;
+	result.missed = 0;
+	result.extra = 0;
+	result.latencies = 0;
+
+	user_io_init();
+	bench_advance(BENCH_GAP_MIN_US);
+
+	for (uint32_t n = 0; n < BENCH_PRESSES; n++) {
+		bench_press_end();
+		bench_in_press = true;
+		bench_released = false;
+		bench_press_clicks = 0;
+		bench_press_start_us = bench_now_us;
+
+		bench_bounce(true, bounce_us);
+		bench_steady(true, bench_press_start_us + (press_us / 2U) + bench_rand(press_us + 1U), scenario->glitches);
+
+		bench_bounce(false, bounce_us);
+		bench_released = true;
+		bench_press_deadline_us = bench_now_us + (BENCH_WINDOW_MS * 1000U) + BENCH_PERIOD_US;
+		bench_steady(false, bench_now_us + BENCH_GAP_MIN_US + bench_rand(BENCH_GAP_RANGE_US), scenario->glitches);
+	}
+
+	bench_press_end();
+}
+
+
+
+/**
+ * @fn int bench_compare(const void*, const void*)
+ * @brief Orders latencies for qsort()
+ *
+ * @param a (const void*)
+ * @param b (const void*)
+ * @return (int)
+ */
+static int bench_compare(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *) a;
+	uint32_t y = *(const uint32_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+
+
+/**
+ * @fn uint32_t bench_percentile(uint32_t)
+ * @brief Returns latency percent of presses with a click stayed within, latencies must be sorted
+ *
+ * @param percent (uint32_t)
+ * @return (uint32_t) latency in us, 0 if no press was registered
+ */
+static uint32_t bench_percentile(uint32_t percent) {
+	if (!result.latencies) {
+		return 0;
+	}
+
+	uint32_t index = ((result.latencies * percent) + 99U) / 100U;
+
+	return result.latency_us[(index? index : 1U) - 1U];
+}
+
+
+
+/**
+ * @fn void bench_print(void)
+ * @brief Prints one table row of last run
+ *
+ */
+static void bench_print(void) {
+	qsort(result.latency_us, result.latencies, sizeof(result.latency_us[0]), bench_compare);
+
+	printf("%3u ms  %3u ms  %3u ms  | %7.2f  %7.2f | %14lu  %6lu  %6lu  %6lu\n",
+			(unsigned) USER_IO_HANDLER_PERIOD_MS, (unsigned) BENCH_PRESS_MS, (unsigned) BENCH_RELEASE_MS,
+			(100.0 * result.missed) / BENCH_PRESSES, (100.0 * result.extra) / BENCH_PRESSES,
+			(unsigned long) bench_percentile(50), (unsigned long) bench_percentile(90),
+			(unsigned long) bench_percentile(99), (unsigned long) bench_percentile(100));
+}
@@ -0,0 +1,72 @@
+#!/bin/sh
+#
+# Builds debounce_bench for every handler period and debounce setting below and
+# prints one table per bounce scenario. Threshold settings come first, then the press
+# and release settings of BTN_DEBOUNCE_INTEGRATOR_USE. Extra arguments are passed to
+# the compiler, e.g. -DBTN_DEBOUNCE_EAGER_USE, which skips the integrator settings.
+# Run from anywhere, needs gcc.
+#
+# Usage: tools/debounce_bench/sweep.sh [compiler flags]
+
+set -e
+
+PERIODS_MS="1 5 10"
+DEBOUNCES_MS="10 20 40"
+# press_ms,release_ms
+INTEGRATORS_MS="5,20 10,30 20,40"
+# bounce_ms press_ms glitches_per_1000_ms
+SCENARIOS="1,100,0 5,100,0 10,100,0 5,40,0 5,20,0 5,100,5 10,100,20"
+
+case " $* " in
+	*" -DBTN_DEBOUNCE_EAGER_USE "*|*" -DBTN_DEBOUNCE_INTEGRATOR_USE "*)
+		INTEGRATORS_MS=""
+		;;
+esac
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(cd "$BENCH_DIR/../.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# Usage: build <setting> <sed script for user_io_config.h> [compiler flags]
+build() {
+	setting=$1
+	edit=$2
+	shift 2
+
+	mkdir -p "$WORK/inc_$setting"
+	cp "$ROOT"/user_io/inc/*.h "$WORK/inc_$setting/"
+	sed -i "$edit" "$WORK/inc_$setting/user_io_config.h"
+
+	for period in $PERIODS_MS; do
+		gcc -std=c99 -O2 -DTIMx_PERIOD_MS="$period" "$@" -I"$WORK/inc_$setting" -include "$BENCH_DIR/bench_hal.h" \
+			"$ROOT/user_io/src/user_io.c" "$ROOT/user_io/src/user_io_driver.c" "$BENCH_DIR/debounce_bench.c" \
+			-o "$WORK/bench_${period}_$setting"
+	done
+}
+
+SETTINGS=""
+for debounce in $DEBOUNCES_MS; do
+	build "$debounce" "s/^#define BTN_DEBOUNCE_TRESHOLD_MS [0-9]*/#define BTN_DEBOUNCE_TRESHOLD_MS $debounce/" "$@"
+	SETTINGS="$SETTINGS $debounce"
+done
+for integrator in $INTEGRATORS_MS; do
+	press=${integrator%,*}
+	release=${integrator#*,}
+	build "i${press}_$release" "s/^#define BTN_DEBOUNCE_PRESS_MS [0-9]*/#define BTN_DEBOUNCE_PRESS_MS $press/; s/^#define BTN_DEBOUNCE_RELEASE_MS [0-9]*/#define BTN_DEBOUNCE_RELEASE_MS $release/" \
+		-DBTN_DEBOUNCE_INTEGRATOR_USE "$@"
+	SETTINGS="$SETTINGS i${press}_$release"
+done
+
+for scenario in $SCENARIOS; do
+	set -- $(echo "$scenario" | tr ',' ' ')
+	echo "bounce $1 ms, press $2 ms, $3 glitches per 1000 ms"
+	echo "period  press   release | missed %  false % | latency us  p50     p90     p99     max"
+
+	for period in $PERIODS_MS; do
+		for setting in $SETTINGS; do
+			"$WORK/bench_${period}_$setting" "$1" "$2" "$3"
+		done
+	done
+	echo
+done
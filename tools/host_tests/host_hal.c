@@ -0,0 +1,358 @@
+/**
+ *
+ * @file host_hal.c
+ * @version 1.1.0
+ *
+ * ------------------------------
+ *
+ * @author https://github.com/AJ747
+ * @date Jul 12, 2025
+ *
+ * ------------------------------
+ *
+ * @brief Fake peripherals for host tests, behave like the hardware user_io_driver.c expects
+ *
+ */
+
+
+
+//---------------------------//
+// Include begin
+//---------------------------//
+#include "user_io.h"
+//---------------------------//
+// Include end
+//---------------------------//
+
+
+
+//---------------------------//
+// Variable begin
+//---------------------------//
+volatile uint8_t host_pin[HOST_PINS];
+volatile uint32_t host_now_us = 0;
+volatile uint32_t host_led_bsrr = 0;
+
+static const uint32_t *host_dma_words = 0;
+static uint32_t host_dma_copy[0x10000]; // Half being played out as it was when it started
+static uint16_t host_dma_len = 0;
+static uint16_t host_dma_pos = 0;
+static uint32_t host_dma_overwritten = 0;
+
+static uint16_t host_adc_level[HOST_ADC_CHANNELS];
+static uint16_t host_adc_noise[HOST_ADC_CHANNELS];
+static uint32_t host_seed = 1;
+
+uint8_t host_expander_reg[HOST_EXPANDER_REGS];
+static uint8_t *host_expander_rx = 0; // Read in flight
+static const uint8_t *host_expander_tx = 0; // Write in flight
+static uint8_t host_expander_first = 0;
+static uint8_t host_expander_len = 0;
+static uint32_t host_expander_read_count = 0;
+static uint32_t host_expander_write_count = 0;
+static uint32_t host_expander_overlap_count = 0;
+//---------------------------//
+// Variable end
+//---------------------------//
+
+
+
+/**
+ * @fn void host_reset(void)
+ * @brief Releases all inputs and stops fake transfers, call before user_io_init()
+ * 
+ */
+void host_reset(void) {
+	for (uint8_t pin = 0; pin < HOST_PINS; pin++) {
+		host_pin[pin] = 1;
+	}
+	host_now_us = 0;
+	host_seed = 1;
+	host_dma_stop();
+	
+	for (uint8_t channel = 0; channel < HOST_ADC_CHANNELS; channel++) {
+		host_adc_set(channel, HOST_ADC_MAX, 0);
+	}
+	
+	for (uint8_t reg = 0; reg < HOST_EXPANDER_REGS; reg++) {
+		host_expander_reg[reg] = 0;
+	}
+	host_expander_rx = 0;
+	host_expander_tx = 0;
+	host_expander_read_count = 0;
+	host_expander_write_count = 0;
+	host_expander_overlap_count = 0;
+}
+
+
+
+/**
+ * @fn uint32_t host_rand(uint32_t)
+ * @brief Returns pseudo random number below range, same sequence after every host_reset()
+ * 
+ * @param range (uint32_t)
+ * @return (uint32_t)
+ */
+uint32_t host_rand(uint32_t range) {
+	host_seed = (host_seed * 1103515245U) + 12345U;
+	
+	return (host_seed >> 8) % range;
+}
+
+
+
+/**
+ * @fn void host_dma_stop(void)
+ * @brief Stops fake circular DMA
+ * 
+ */
+void host_dma_stop(void) {
+	host_dma_words = 0;
+	host_dma_len = 0;
+	host_dma_pos = 0;
+	host_dma_overwritten = 0;
+}
+
+
+
+/**
+ * @fn void host_dma_start(const uint32_t*, uint16_t)
+ * @brief Starts fake circular DMA into LED port, first word goes out on next host_dma_tick()
+ * 
+ * @param words (const uint32_t*)
+ * @param len (uint16_t) amount of words, two halves
+ */
+void host_dma_start(const uint32_t *words, uint16_t len) {
+	host_dma_words = words;
+	host_dma_len = len;
+	host_dma_pos = 0;
+	
+	for (uint16_t i = 0; i < len; i++) {
+		host_dma_copy[i] = words[i];
+	}
+}
+
+
+
+/**
+ * @fn void host_dma_tick(void)
+ * @brief Plays out one word like a timer triggered DMA into a set/reset register, LEDn is pin LED0_PIN + n
+ * 
+ * @note Signals half transfer and transfer complete like the DMA interrupts would,
+ * a word that changed since its half started playing is counted as overwritten
+ */
+void host_dma_tick(void) {
+	if (!host_dma_len) {
+		return;
+	}
+	
+	uint16_t half = host_dma_len / 2U;
+	uint32_t word = host_dma_words[host_dma_pos];
+	
+	if (word != host_dma_copy[host_dma_pos]) {
+		host_dma_overwritten++;
+	}
+	
+	host_led_bsrr = word;
+	for (uint8_t bit = 0; bit < 16; bit++) {
+		if ((LED0_PIN + bit) >= HOST_PINS) {
+			break;
+		}
+		if (word & ((uint32_t) 1U << bit)) {
+			host_pin[LED0_PIN + bit] = 1;
+		}
+		if (word & ((uint32_t) 1U << (bit + 16))) {
+			host_pin[LED0_PIN + bit] = 0;
+		}
+	}
+	
+	if (++host_dma_pos == host_dma_len) {
+		host_dma_pos = 0;
+	}
+	
+	// Half that starts now is copied to find writes while it plays
+	if ((host_dma_pos == 0) || (host_dma_pos == half)) {
+		for (uint16_t i = 0; i < half; i++) {
+			host_dma_copy[host_dma_pos + i] = host_dma_words[host_dma_pos + i];
+		}
+#ifdef LED_WAVEFORM_USE
+		led_waveform_half_done();
+#endif
+	}
+}
+
+
+
+/**
+ * @fn uint32_t host_dma_overwrites(void)
+ * @brief Returns words played out that were written while their half was being played out
+ * 
+ * @return (uint32_t)
+ */
+uint32_t host_dma_overwrites(void) {
+	return host_dma_overwritten;
+}
+
+
+
+/**
+ * @fn void host_adc_set(uint8_t, uint16_t, uint16_t)
+ * @brief Sets voltage on fake ADC channel
+ * 
+ * @param channel (uint8_t)
+ * @param level (uint16_t) mean ADC value
+ * @param noise (uint16_t) every read is off by up to noise either way, clipped to ADC range
+ */
+void host_adc_set(uint8_t channel, uint16_t level, uint16_t noise) {
+	host_adc_level[channel] = level;
+	host_adc_noise[channel] = noise;
+}
+
+
+
+/**
+ * @fn uint16_t host_adc_read(uint8_t)
+ * @brief Returns one conversion of fake ADC channel
+ * 
+ * @param channel (uint8_t)
+ * @return (uint16_t)
+ */
+uint16_t host_adc_read(uint8_t channel) {
+	int32_t noise = host_adc_noise[channel];
+	int32_t sample = (int32_t) host_adc_level[channel] + ((int32_t) host_rand((uint32_t) (2 * noise) + 1U) - noise);
+	
+	if (sample < 0) {
+		return 0;
+	}
+	return (sample > (int32_t) HOST_ADC_MAX)? HOST_ADC_MAX : (uint16_t) sample;
+}
+
+
+
+/**
+ * @fn void host_expander_write(uint8_t, const uint8_t*, uint8_t, bool)
+ * @brief Writes len consecutive fake expander registers
+ * 
+ * @param reg (uint8_t) first register
+ * @param data (const uint8_t*) read when transfer completes
+ * @param len (uint8_t) amount of registers
+ * @param dma (bool) false writes at once, true waits for host_expander_complete()
+ * 
+ * @note A transfer started while another is in flight is counted as overlap
+ */
+void host_expander_write(uint8_t reg, const uint8_t *data, uint8_t len, bool dma) {
+	if (!dma) {
+		for (uint8_t i = 0; i < len; i++) {
+			host_expander_reg[reg + i] = data[i];
+		}
+		return;
+	}
+	
+	if (host_expander_pending()) {
+		host_expander_overlap_count++;
+	}
+	host_expander_write_count++;
+	host_expander_tx = data;
+	host_expander_first = reg;
+	host_expander_len = len;
+}
+
+
+
+/**
+ * @fn void host_expander_read(uint8_t, uint8_t*, uint8_t)
+ * @brief Reads len consecutive fake expander registers once host_expander_complete() is called
+ * 
+ * @param reg (uint8_t) first register
+ * @param data (uint8_t*) filled when transfer completes
+ * @param len (uint8_t) amount of registers
+ */
+void host_expander_read(uint8_t reg, uint8_t *data, uint8_t len) {
+	if (host_expander_pending()) {
+		host_expander_overlap_count++;
+	}
+	host_expander_read_count++;
+	host_expander_rx = data;
+	host_expander_first = reg;
+	host_expander_len = len;
+}
+
+
+
+/**
+ * @fn bool host_expander_pending(void)
+ * @brief Checks if a fake expander transfer is in flight
+ * 
+ * @return (bool)
+ */
+bool host_expander_pending(void) {
+	return (host_expander_rx != 0) || (host_expander_tx != 0);
+}
+
+
+
+/**
+ * @fn void host_expander_complete(bool)
+ * @brief Ends transfer in flight like the bus callback would, copies data only if ok
+ * 
+ * @param ok (bool) false fails transfer
+ * 
+ * @note Calls expander_transfer_done(), which may start the next transfer
+ */
+void host_expander_complete(bool ok) {
+	uint8_t *rx = host_expander_rx;
+	const uint8_t *tx = host_expander_tx;
+	
+	if (!rx && !tx) {
+		return;
+	}
+	host_expander_rx = 0;
+	host_expander_tx = 0;
+	
+	for (uint8_t i = 0; ok && (i < host_expander_len); i++) {
+		if (rx) {
+			rx[i] = host_expander_reg[host_expander_first + i];
+		} else {
+			host_expander_reg[host_expander_first + i] = tx[i];
+		}
+	}
+#ifdef USER_IO_EXPANDER_USE
+	expander_transfer_done(ok);
+#endif
+}
+
+
+
+/**
+ * @fn uint32_t host_expander_reads(void)
+ * @brief Returns fake expander reads started
+ * 
+ * @return (uint32_t)
+ */
+uint32_t host_expander_reads(void) {
+	return host_expander_read_count;
+}
+
+
+
+/**
+ * @fn uint32_t host_expander_writes(void)
+ * @brief Returns fake expander writes started with DMA
+ * 
+ * @return (uint32_t)
+ */
+uint32_t host_expander_writes(void) {
+	return host_expander_write_count;
+}
+
+
+
+/**
+ * @fn uint32_t host_expander_overlaps(void)
+ * @brief Returns transfers started while another one was in flight
+ * 
+ * @return (uint32_t)
+ */
+uint32_t host_expander_overlaps(void) {
+	return host_expander_overlap_count;
+}
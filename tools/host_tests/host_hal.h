@@ -0,0 +1,133 @@
+/**
+ *
+ * @file host_hal.h
+ * @version 1.1.0
+ *
+ * ------------------------------
+ *
+ * @author https://github.com/AJ747
+ * @date Jul 12, 2025
+ *
+ * ------------------------------
+ *
+ * @brief Stub pin layer and fake peripherals for host tests, pins are plain variables
+ *
+ */
+
+#ifndef TOOLS_HOST_TESTS_HOST_HAL_H_
+#define TOOLS_HOST_TESTS_HOST_HAL_H_
+
+
+
+//---------------------------//
+// Include begin
+//---------------------------//
+#include <stdint.h>
+#include <stdbool.h>
+//---------------------------//
+// Include end
+//---------------------------//
+
+
+
+//---------------------------//
+// Define begin
+//---------------------------//
+#ifndef TIMx_PERIOD_MS
+#define TIMx_PERIOD_MS 10
+#endif
+
+#define SW0_PIN 0
+#define SW1_PIN 1
+#define BTN0_PIN 2
+#define BTN1_PIN 3
+#define BTN2_PIN 4
+#define LED0_PIN 5 // LEDn is on pin LED0_PIN + n, like bit n of a port
+#define LED1_PIN 6
+#define LED2_PIN 7
+#define HOST_PINS 8
+
+#define INPUT_PULL_UP 0
+#define OUTPUT 1
+
+#define PIN_CONFIG(pin, mode) ((void) (pin), (void) (mode))
+#ifdef USER_IO_EXPANDER_USE
+// All pins sit on fake expander port 0, see host_expander_complete()
+#define PIN_READ(pin) expander_pin_read(pin)
+#define PIN_HIGH(pin) expander_pin_write((pin), true)
+#define PIN_LOW(pin) expander_pin_write((pin), false)
+#define PIN_TOGGLE(pin) expander_pin_toggle(pin)
+#else
+#define PIN_READ(pin) (host_pin[(pin)])
+#define PIN_HIGH(pin) (host_pin[(pin)] = 1)
+#define PIN_LOW(pin) (host_pin[(pin)] = 0)
+#define PIN_TOGGLE(pin) (host_pin[(pin)] ^= 1)
+#endif
+
+#define TIMESTAMP_US() (host_now_us)
+
+// LED port played out by fake DMA, see host_dma_tick()
+#define LED_PORT_BSRR host_led_bsrr
+#define DMA_STOP() host_dma_stop()
+#define DMA_START_CIRCULAR(src, dst, len) ((void) (dst), host_dma_start((src), (len)))
+
+// 12 bit ADC read by btn_ladder_get_samples(), see host_adc_set()
+#define HOST_ADC_CHANNELS 4
+#define HOST_ADC_MAX 4095U
+#define BTN_LADDER_ADC 0
+#define BTN_LADDER0_CHANNEL 0
+#define ADC_CONFIG(adc, channel) ((void) (adc), (void) (channel))
+#define ADC_READ(adc, channel) ((void) (adc), host_adc_read(channel))
+
+// Fake expander registers, 0 after host_reset(). Transfers complete on host_expander_complete() like a bus callback
+#define HOST_EXPANDER_REGS 0x20
+#define I2C_WRITE(bus, addr, reg, data, len) host_expander_write((reg), (data), (len), false)
+#define I2C_WRITE_DMA(bus, addr, reg, data, len) host_expander_write((reg), (data), (len), true)
+#define I2C_READ_DMA(bus, addr, reg, data, len) host_expander_read((reg), (data), (len))
+//---------------------------//
+// Define end
+//---------------------------//
+
+
+
+//---------------------------//
+// Variable begin
+//---------------------------//
+extern volatile uint8_t host_pin[HOST_PINS];
+extern volatile uint32_t host_now_us;
+extern volatile uint32_t host_led_bsrr;
+extern uint8_t host_expander_reg[HOST_EXPANDER_REGS];
+//---------------------------//
+// Variable end
+//---------------------------//
+
+
+
+//---------------------------//
+// Prototypes begin
+//---------------------------//
+void host_reset(void);
+uint32_t host_rand(uint32_t range);
+
+void host_dma_stop(void);
+void host_dma_start(const uint32_t *words, uint16_t len);
+void host_dma_tick(void);
+uint32_t host_dma_overwrites(void);
+
+void host_adc_set(uint8_t channel, uint16_t level, uint16_t noise);
+uint16_t host_adc_read(uint8_t channel);
+
+void host_expander_write(uint8_t reg, const uint8_t *data, uint8_t len, bool dma);
+void host_expander_read(uint8_t reg, uint8_t *data, uint8_t len);
+bool host_expander_pending(void);
+void host_expander_complete(bool ok);
+uint32_t host_expander_reads(void);
+uint32_t host_expander_writes(void);
+uint32_t host_expander_overlaps(void);
+//---------------------------//
+// Prototypes end
+//---------------------------//
+
+
+
+#endif /* TOOLS_HOST_TESTS_HOST_HAL_H_ */
@@ -0,0 +1,78 @@
+#!/bin/sh
+#
+# Builds every host test against the library sources with the fakes in host_hal.c and
+# runs it. Tests that print a trace are built in two configurations whose traces must
+# match. Linux port tests build user_io_driver_linux.c with simulated pins instead of
+# the fakes. Extra arguments are passed to the compiler. Run from anywhere, needs gcc.
+#
+# Usage: tools/host_tests/run.sh [compiler flags]
+
+set -e
+
+TESTS_DIR=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(cd "$TESTS_DIR/../.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+EXTRA_FLAGS="$*"
+
+# build <name> <test source> [flags]
+build() {
+	name=$1
+	source=$2
+	shift 2
+	gcc -std=c99 -O1 -Wall -Wextra $EXTRA_FLAGS "$@" -I"$ROOT/user_io/inc" -include "$TESTS_DIR/host_hal.h" \
+		"$ROOT/user_io/src/user_io.c" "$ROOT/user_io/src/user_io_driver.c" "$TESTS_DIR/host_hal.c" \
+		"$TESTS_DIR/$source" -o "$WORK/$name"
+}
+
+# check <name> <test source> [flags]
+check() {
+	name=$1
+	source=$2
+	shift 2
+	build "$name" "$source" "$@"
+	if ! "$WORK/$name"; then
+		echo "$name: FAIL"
+		exit 1
+	fi
+	echo "$name: OK"
+}
+
+# linux_check <name> <test source> [flags], Linux port with simulated pins instead of host_hal.c
+linux_check() {
+	name=$1
+	source=$2
+	shift 2
+	gcc -std=c99 -O1 -Wall -Wextra $EXTRA_FLAGS "$@" -DTIMx_PERIOD_MS=10 -DUSER_IO_LINUX_USE -DUSER_IO_LINUX_SIM_PINS \
+		-I"$ROOT/user_io/inc" "$ROOT/user_io/src/user_io.c" "$ROOT/user_io/src/user_io_driver.c" \
+		"$ROOT/user_io/src/user_io_driver_linux.c" "$TESTS_DIR/$source" -o "$WORK/$name"
+	if ! "$WORK/$name"; then
+		echo "$name: FAIL"
+		exit 1
+	fi
+	echo "$name: OK"
+}
+
+# compare <name> <test source> <flags a> <flags b>
+compare() {
+	build "$1_a" "$2" $3
+	build "$1_b" "$2" $4
+	if ! "$WORK/$1_a" > "$WORK/$1_a.txt" || ! "$WORK/$1_b" > "$WORK/$1_b.txt"; then
+		echo "$1: FAIL"
+		exit 1
+	fi
+	if ! cmp -s "$WORK/$1_a.txt" "$WORK/$1_b.txt"; then
+		echo "$1: FAIL, traces differ"
+		diff "$WORK/$1_a.txt" "$WORK/$1_b.txt" | head -n 20
+		exit 1
+	fi
+	echo "$1: OK"
+}
+
+compare waveform test_waveform.c "" "-DLED_WAVEFORM_USE"
+compare sparse test_sparse.c "" "-DUSER_IO_SPARSE_USE"
+compare sparse_hold test_sparse.c "-DBTN_HOLD_EVENTS_USE -DLED_STATS_USE" "-DBTN_HOLD_EVENTS_USE -DLED_STATS_USE -DUSER_IO_SPARSE_USE"
+check ladder test_ladder.c -DBTN_LADDER_USE
+check expander test_expander.c -DUSER_IO_EXPANDER_USE
+linux_check linux_sim test_linux_sim.c
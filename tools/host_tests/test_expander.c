@@ -0,0 +1,170 @@
+/**
+ *
+ * @file test_expander.c
+ * @version 1.1.0
+ *
+ * ------------------------------
+ *
+ * @author https://github.com/AJ747
+ * @date Jul 12, 2025
+ *
+ * ------------------------------
+ *
+ * @brief Host test, runs buttons and LEDs on the fake expander of host_hal.c. Checks one
+ * read per tick, burst writes of changed latches, inputs changing only at start of a tick,
+ * a bus slower than the handler and retries of failed transfers
+ *
+ */
+
+
+
+//---------------------------//
+// Include begin
+//---------------------------//
+#include <stdio.h>
+#include "user_io.h"
+//---------------------------//
+// Include end
+//---------------------------//
+
+
+
+//---------------------------//
+// Define begin
+//---------------------------//
+#define TEST_INPUTS host_expander_reg[EXPANDER_INPUT_REG]
+#define TEST_LATCH(pin) ((host_expander_reg[EXPANDER_OUTPUT_REG + ((pin) >> 3)] >> ((pin) & 7U)) & 1U)
+#define TEST_DEBOUNCE_TICKS (2 * (BTN_DEBOUNCE_TRESHOLD_MS / USER_IO_HANDLER_PERIOD_MS) + 2)
+
+#define TEST_EXPECT(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("line %d: %s\n", __LINE__, #cond); \
+			failed = 1; \
+		} \
+	} while (0)
+//---------------------------//
+// Define end
+//---------------------------//
+
+
+
+/**
+ * @fn void test_tick(void)
+ * @brief Runs one tick on a bus that finishes every transfer before the next tick
+ * 
+ */
+static void test_tick(void) {
+	user_io_irq_handler();
+	while (host_expander_pending()) {
+		host_expander_complete(true);
+	}
+}
+
+
+
+/**
+ * @fn int main(void)
+ * @brief Runs all checks, prints every failed one
+ * 
+ * @return (int) 1 if a check failed
+ */
+int main(void) {
+	int failed = 0;
+	
+	host_reset();
+	TEST_INPUTS = 0xFF;
+	user_io_init();
+	
+	// Idle, one read per tick and no writes
+	for (int i = 0; i < 10; i++) {
+		test_tick();
+	}
+	TEST_EXPECT(host_expander_reads() == 10);
+	TEST_EXPECT(host_expander_writes() == 0);
+	
+	// Changed latch is written once, before inputs are read
+	led_on(LED1);
+	test_tick();
+	test_tick();
+	TEST_EXPECT(host_expander_writes() == 1);
+	TEST_EXPECT(TEST_LATCH(LED1_PIN));
+	
+	// Changes on two ports go out in one burst
+	expander_pin_write(EXPANDER_PIN(0, 0), true);
+	expander_pin_write(EXPANDER_PIN(1, 3), true);
+	test_tick();
+	TEST_EXPECT(host_expander_writes() == 2);
+	TEST_EXPECT(TEST_LATCH(EXPANDER_PIN(0, 0)) && TEST_LATCH(EXPANDER_PIN(1, 3)) && TEST_LATCH(LED1_PIN));
+	
+	// Completed read is handed over at start of next tick, never in between
+	user_io_irq_handler();
+	TEST_INPUTS &= (uint8_t) ~(1U << BTN0_PIN);
+	host_expander_complete(true);
+	TEST_EXPECT(expander_port_read(0) == 0xFF);
+	TEST_EXPECT(!host_expander_pending());
+	user_io_irq_handler();
+	TEST_EXPECT(expander_port_read(0) == TEST_INPUTS);
+	host_expander_complete(true);
+	
+	// Button on expander is debounced like any other
+	bool clicked = false;
+	
+	for (int i = 0; (i < TEST_DEBOUNCE_TICKS) && !clicked; i++) {
+		test_tick();
+		clicked = btn_click(BTN0);
+	}
+	TEST_EXPECT(clicked);
+	TEST_INPUTS = 0xFF;
+	for (int i = 0; i < TEST_DEBOUNCE_TICKS; i++) {
+		test_tick();
+	}
+	TEST_EXPECT(btn_released(BTN0));
+	
+	// Bus slower than the handler, transfers never overlap and LEDs still follow
+	uint32_t reads = host_expander_reads();
+	uint32_t writes = host_expander_writes();
+	uint32_t changes = 0;
+	uint8_t latch = (uint8_t) TEST_LATCH(LED0_PIN);
+	
+	led_blink_infinite(LED0, 2 * USER_IO_HANDLER_PERIOD_MS);
+	for (int i = 0; i < 60; i++) {
+		user_io_irq_handler();
+		if ((i % 3) == 2) {
+			host_expander_complete(true);
+		}
+		if (TEST_LATCH(LED0_PIN) != latch) {
+			latch = (uint8_t) TEST_LATCH(LED0_PIN);
+			changes++;
+		}
+	}
+	test_tick();
+	TEST_EXPECT(host_expander_overlaps() == 0);
+	TEST_EXPECT((host_expander_reads() - reads) >= 5);
+	TEST_EXPECT((host_expander_writes() - writes) >= 5);
+	TEST_EXPECT(changes >= 5);
+	
+	// Failed write is counted and retried on next tick, not right away
+	led_off(LED0);
+	led_force_off(LED0);
+	test_tick();
+	writes = host_expander_writes();
+	
+	led_on(LED2);
+	user_io_irq_handler();
+	host_expander_complete(false);
+	TEST_EXPECT(expander_errors() == 1);
+	TEST_EXPECT(!host_expander_pending());
+	TEST_EXPECT(!TEST_LATCH(LED2_PIN));
+	test_tick();
+	TEST_EXPECT((host_expander_writes() - writes) == 2);
+	TEST_EXPECT(TEST_LATCH(LED2_PIN));
+	
+	// Late ticks flush latches too
+	led_off(LED2);
+	user_io_handler_elapsed(5);
+	host_expander_complete(true);
+	TEST_EXPECT(!TEST_LATCH(LED2_PIN));
+	
+	return failed;
+}
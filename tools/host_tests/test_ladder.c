@@ -0,0 +1,168 @@
+/**
+ *
+ * @file test_ladder.c
+ * @version 1.1.0
+ *
+ * ------------------------------
+ *
+ * @author https://github.com/AJ747
+ * @date Jul 12, 2025
+ *
+ * ------------------------------
+ *
+ * @brief Host test, drives the default BTN_LADDER_BANDS through a fake ADC with noise,
+ * band edge values and values within hysteresis and checks every click and release
+ *
+ */
+
+
+
+//---------------------------//
+// Include begin
+//---------------------------//
+#include <stdio.h>
+#include "user_io.h"
+//---------------------------//
+// Include end
+//---------------------------//
+
+
+
+//---------------------------//
+// Define begin
+//---------------------------//
+#define TEST_NONE -1
+#define TEST_IDLE HOST_ADC_MAX
+#define TEST_HYST BTN_LADDER_HYSTERESIS
+
+#if (TEST_HYST < 2) || (TEST_HYST > 300)
+#error "steps below expect a hysteresis of 2 to 300 ADC counts"
+#endif
+//---------------------------//
+// Define end
+//---------------------------//
+
+
+
+//---------------------------//
+// Typedef begin
+//---------------------------//
+struct test_step {
+	uint16_t level;			// Mean ADC value
+	uint16_t noise;			// Each read is off by up to this either way
+	uint16_t ticks;
+	int clicked;			// Only button expected to click during step, TEST_NONE if none
+	int released;			// Only button expected to be released during step
+};
+//---------------------------//
+// Typedef end
+//---------------------------//
+
+
+
+//---------------------------//
+// Variable begin
+//---------------------------//
+// Bands {0, 400, BTN0}, {1600, 2400, BTN1}, {2800, 3400, BTN2} on channel 0
+static const struct test_step test_steps[] = {
+	// Idle line with noise
+	{TEST_IDLE, 40, 100, TEST_NONE, TEST_NONE},
+	
+	// Noisy presses well within bands
+	{200, 100, 30, BTN0, TEST_NONE},
+	{TEST_IDLE, 0, 30, TEST_NONE, BTN0},
+	{2000, 300, 30, BTN1, TEST_NONE},
+	{TEST_IDLE, 0, 30, TEST_NONE, BTN1},
+	{3100, 250, 30, BTN2, TEST_NONE},
+	{TEST_IDLE, 0, 30, TEST_NONE, BTN2},
+	
+	// Band edges are inside
+	{0, 0, 30, BTN0, TEST_NONE},
+	{TEST_IDLE, 0, 30, TEST_NONE, BTN0},
+	{400, 0, 30, BTN0, TEST_NONE},
+	{TEST_IDLE, 0, 30, TEST_NONE, BTN0},
+	{1600, 0, 30, BTN1, TEST_NONE},
+	{TEST_IDLE, 0, 30, TEST_NONE, BTN1},
+	{2400, 0, 30, BTN1, TEST_NONE},
+	{TEST_IDLE, 0, 30, TEST_NONE, BTN1},
+	{2800, 0, 30, BTN2, TEST_NONE},
+	{TEST_IDLE, 0, 30, TEST_NONE, BTN2},
+	{3400, 0, 30, BTN2, TEST_NONE},
+	{TEST_IDLE, 0, 30, TEST_NONE, BTN2},
+	
+	// Just outside isn't entered, hysteresis only applies once in a band
+	{401, 0, 30, TEST_NONE, TEST_NONE},
+	{1599, 0, 30, TEST_NONE, TEST_NONE},
+	{2401, 0, 30, TEST_NONE, TEST_NONE},
+	{2799, 0, 30, TEST_NONE, TEST_NONE},
+	{3401, 0, 30, TEST_NONE, TEST_NONE},
+	{TEST_IDLE, 0, 30, TEST_NONE, TEST_NONE},
+	
+	// Pressed band is left only beyond hysteresis
+	{2000, 0, 30, BTN1, TEST_NONE},
+	{2400 + TEST_HYST, 0, 30, TEST_NONE, TEST_NONE},
+	{1600 - TEST_HYST, 0, 30, TEST_NONE, TEST_NONE},
+	{2400 + TEST_HYST + 1, 0, 30, TEST_NONE, BTN1},
+	{TEST_IDLE, 0, 30, TEST_NONE, TEST_NONE},
+	{200, 0, 30, BTN0, TEST_NONE},
+	{400 + TEST_HYST + 1, 0, 30, TEST_NONE, BTN0},
+	{TEST_IDLE, 0, 30, TEST_NONE, TEST_NONE},
+	
+	// Noise around a band edge presses once and doesn't chatter
+	{2400, TEST_HYST - 1, 100, BTN1, TEST_NONE},
+	{TEST_IDLE, 0, 30, TEST_NONE, BTN1},
+	{1600, TEST_HYST - 1, 100, BTN1, TEST_NONE},
+	{TEST_IDLE, 0, 30, TEST_NONE, BTN1},
+	{2800, TEST_HYST - 1, 100, BTN2, TEST_NONE},
+	{TEST_IDLE, 0, 30, TEST_NONE, BTN2},
+};
+//---------------------------//
+// Variable end
+//---------------------------//
+
+
+
+/**
+ * @fn int main(void)
+ * @brief Runs all steps, prints every unexpected or missing event
+ * 
+ * @return (int) 1 if an event was unexpected or missing
+ */
+int main(void) {
+	int failed = 0;
+	
+	host_reset();
+	user_io_init();
+	
+	for (size_t i = 0; i < (sizeof(test_steps) / sizeof(test_steps[0])); i++) {
+		const struct test_step *step = &test_steps[i];
+		uint32_t clicks[BTNS_AMOUNT] = {0};
+		uint32_t releases[BTNS_AMOUNT] = {0};
+		
+		host_adc_set(0, step->level, step->noise);
+		
+		for (uint16_t tick = 0; tick < step->ticks; tick++) {
+			user_io_irq_handler();
+			
+			for (int id = 0; id < BTNS_AMOUNT; id++) {
+				clicks[id] += btn_click((enum btn_id) id);
+				releases[id] += btn_released((enum btn_id) id);
+			}
+		}
+		
+		for (int id = 0; id < BTNS_AMOUNT; id++) {
+			uint32_t want_clicks = (id == step->clicked)? 1U : 0U;
+			uint32_t want_releases = (id == step->released)? 1U : 0U;
+			
+			if ((clicks[id] != want_clicks) || (releases[id] != want_releases)) {
+				printf("step %u, level %u noise %u: BTN%d clicked %lu released %lu times, expected %lu and %lu\n",
+						(unsigned) i, (unsigned) step->level, (unsigned) step->noise, id,
+						(unsigned long) clicks[id], (unsigned long) releases[id],
+						(unsigned long) want_clicks, (unsigned long) want_releases);
+				failed = 1;
+			}
+		}
+	}
+	
+	return failed;
+}
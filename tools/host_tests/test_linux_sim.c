@@ -0,0 +1,145 @@
+/**
+ *
+ * @file test_linux_sim.c
+ * @version 1.1.0
+ *
+ * ------------------------------
+ *
+ * @author https://github.com/AJ747
+ * @date Jul 12, 2025
+ *
+ * ------------------------------
+ *
+ * @brief Host test, runs Linux port with USER_IO_LINUX_SIM_PINS on the default line lists.
+ * Checks input events, LED output, batched writes and catching up after a late wake-up
+ *
+ */
+
+
+
+//---------------------------//
+// Include begin
+//---------------------------//
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <time.h>
+#include "user_io.h"
+#include "user_io_linux.h"
+//---------------------------//
+// Include end
+//---------------------------//
+
+
+
+//---------------------------//
+// Define begin
+//---------------------------//
+// Line offsets of default USER_IO_LINUX_*_LINES
+#define TEST_SW1_LINE 6
+#define TEST_BTN1_LINE 27
+#define TEST_LED1_LINE 24
+
+#define TEST_EXPECT(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("line %d: %s\n", __LINE__, #cond); \
+			failed = 1; \
+		} \
+	} while (0)
+//---------------------------//
+// Define end
+//---------------------------//
+
+
+
+//---------------------------//
+// Variable begin
+//---------------------------//
+static uint32_t test_polls = 0;
+static uint32_t test_led_changes = 0;
+//---------------------------//
+// Variable end
+//---------------------------//
+
+
+
+/**
+ * @fn int test_poll(int)
+ * @brief Polls until at least ticks handler ticks ran, counts LED1 line changes
+ * 
+ * @param ticks (int)
+ * @return (int) ticks handled, -1 on error
+ */
+static int test_poll(int ticks) {
+	int handled = 0;
+	bool led = user_io_linux_sim_output(TEST_LED1_LINE);
+	
+	while (handled < ticks) {
+		int ret = user_io_linux_poll(-1);
+		
+		if (ret < 0) {
+			return -1;
+		}
+		handled += ret;
+		test_polls++;
+		
+		if (user_io_linux_sim_output(TEST_LED1_LINE) != led) {
+			led = !led;
+			test_led_changes++;
+		}
+	}
+	return handled;
+}
+
+
+
+/**
+ * @fn int main(void)
+ * @brief Runs all checks, prints every failed one
+ * 
+ * @return (int) 1 if a check failed
+ */
+int main(void) {
+	int failed = 0;
+	
+	user_io_init();
+	if (user_io_linux_init() != 0) {
+		printf("user_io_linux_init() failed\n");
+		return 1;
+	}
+	
+	// Edge events are sampled by next tick and debounced
+	user_io_linux_sim_input(TEST_BTN1_LINE, true);
+	TEST_EXPECT(test_poll(2 * (BTN_DEBOUNCE_TRESHOLD_MS / USER_IO_HANDLER_PERIOD_MS) + 2) > 0);
+	TEST_EXPECT(btn_click(BTN1));
+	TEST_EXPECT(!btn_click(BTN0));
+	
+	user_io_linux_sim_input(TEST_BTN1_LINE, false);
+	TEST_EXPECT(test_poll(2 * (BTN_DEBOUNCE_TRESHOLD_MS / USER_IO_HANDLER_PERIOD_MS) + 2) > 0);
+	TEST_EXPECT(btn_released(BTN1));
+	
+	user_io_linux_sim_input(TEST_SW1_LINE, true);
+	TEST_EXPECT(user_io_linux_poll(0) >= 0);
+	TEST_EXPECT(switch_on(SW1));
+	TEST_EXPECT(!switch_on(SW0));
+	
+	// LED writes are batched, at most one per wake-up
+	uint32_t writes = user_io_linux_sim_output_writes();
+	test_polls = 0;
+	
+	led_blink_infinite(LED1, 5 * USER_IO_HANDLER_PERIOD_MS);
+	TEST_EXPECT(test_poll(40) >= 40);
+	TEST_EXPECT(test_led_changes >= 6);
+	TEST_EXPECT((user_io_linux_sim_output_writes() - writes) <= test_polls);
+	
+	// Ticks missed while not polling are handled in one call
+	struct timespec late = {0, 8L * USER_IO_HANDLER_PERIOD_MS * 1000000L};
+	
+	TEST_EXPECT(interval_reached_ms(INTERVAL0, 5 * USER_IO_HANDLER_PERIOD_MS));
+	nanosleep(&late, NULL);
+	TEST_EXPECT(user_io_linux_poll(-1) >= 5);
+	TEST_EXPECT(interval_reached_ms(INTERVAL0, 5 * USER_IO_HANDLER_PERIOD_MS));
+	
+	return failed;
+}
@@ -0,0 +1,132 @@
+/**
+ *
+ * @file test_sparse.c
+ * @version 1.1.0
+ *
+ * ------------------------------
+ *
+ * @author https://github.com/AJ747
+ * @date Jul 12, 2025
+ *
+ * ------------------------------
+ *
+ * @brief Host test, prints LED pin levels and button events after every step of a random
+ * schedule of effects, button changes and late ticks. Built once with and once without
+ * USER_IO_SPARSE_USE by run.sh, both traces must match
+ *
+ */
+
+
+
+//---------------------------//
+// Include begin
+//---------------------------//
+#include <stdio.h>
+#include "user_io.h"
+//---------------------------//
+// Include end
+//---------------------------//
+
+
+
+//---------------------------//
+// Define begin
+//---------------------------//
+#define TEST_STEPS 4000U
+#define TEST_LATE_TICKS 200U // Most ticks handled at once by user_io_handler_elapsed()
+//---------------------------//
+// Define end
+//---------------------------//
+
+
+
+/**
+ * @fn void test_effect(void)
+ * @brief Starts random effect on random LED
+ * 
+ */
+static void test_effect(void) {
+	enum led_id id = (enum led_id) host_rand(LEDS_AMOUNT);
+	uint16_t rate = (uint16_t) ((host_rand(8) * 10U) + 5U);
+	
+	switch (host_rand(8)) {
+	case 0:
+		led_blink_infinite(id, rate);
+		break;
+	case 1:
+		led_blink_ms(id, rate, (uint16_t) host_rand(900));
+		break;
+	case 2:
+		led_blink_n_times(id, rate, (uint16_t) host_rand(9));
+		break;
+	case 3:
+		led_off(id);
+		break;
+	case 4:
+		led_force_off(id);
+		break;
+	case 5:
+		led_on(id);
+		break;
+	case 6:
+		led_pulse(id, (uint16_t) host_rand(600));
+		break;
+	default:
+		led_all_blink_infinite(rate);
+		break;
+	}
+}
+
+
+
+/**
+ * @fn int main(void)
+ * @brief Runs schedule and prints one line of LED levels and button events per step
+ * 
+ * @return (int) 0
+ */
+int main(void) {
+	host_reset();
+	user_io_init();
+	
+#ifdef BTN_HOLD_EVENTS_USE
+	static const uint16_t thresholds[3] = {100, 450, 2000};
+	
+	btn_hold_thresholds_set(BTN0, thresholds, 3);
+	btn_hold_thresholds_set(BTN2, thresholds, 2);
+#endif
+	
+	for (uint32_t step = 0; step < TEST_STEPS; step++) {
+		if (host_rand(3) == 0) {
+			test_effect();
+		}
+		if (host_rand(10) == 0) {
+			host_pin[BTN0_PIN + host_rand(BTNS_AMOUNT)] ^= 1;
+		}
+		
+		// Idle stretches and single ticks, some handled late
+		uint32_t ticks = 1U + host_rand(((step % 5U) == 0)? TEST_LATE_TICKS : 12U);
+		
+		if (host_rand(2)) {
+			user_io_handler_elapsed(ticks);
+		} else {
+			for (uint32_t tick = 0; tick < ticks; tick++) {
+				user_io_irq_handler();
+			}
+		}
+		
+		printf("%u%u%u %d%d%d%d\n", host_pin[LED0_PIN], host_pin[LED1_PIN], host_pin[LED2_PIN],
+				btn_click(BTN0), btn_released(BTN1), btn_depressed(BTN2), btns_no_input_ms(300));
+#ifdef BTN_HOLD_EVENTS_USE
+		printf("hold %d %d %d%d\n", btn_hold_event(BTN0), btn_hold_event(BTN2), btn_hold_ms(BTN0, 300), btn_hold_ms(BTN2, 1000));
+#endif
+#ifdef LED_STATS_USE
+		printf("stats %lu %lu %lu %lu\n", (unsigned long) led_on_time_ms(LED0), (unsigned long) led_on_time_ms(LED2),
+				(unsigned long) led_changes(LED1), (unsigned long) leds_charge_uah());
+#endif
+		if (host_rand(4) == 0) {
+			printf("interval %d\n", interval_reached_ms(INTERVAL0, host_rand(700)));
+		}
+	}
+	return 0;
+}
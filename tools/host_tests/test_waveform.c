@@ -0,0 +1,189 @@
+/**
+ *
+ * @file test_waveform.c
+ * @version 1.1.0
+ *
+ * ------------------------------
+ *
+ * @author https://github.com/AJ747
+ * @date Jul 12, 2025
+ *
+ * ------------------------------
+ *
+ * @brief Host test, prints LED pin levels of every tick for a fixed effect schedule.
+ * Built once with and once without LED_WAVEFORM_USE by run.sh, both traces must match
+ *
+ * Effect calls are placed so they take effect on the same tick in both builds, a call
+ * for tick TEST_HALF * n + 1 is made right after tick TEST_HALF * n tick by tick, and
+ * right after tick TEST_HALF * (n - 1) - 1 with the waveform, before that half is rendered
+ *
+ */
+
+
+
+//---------------------------//
+// Include begin
+//---------------------------//
+#include <stdio.h>
+#include "user_io.h"
+//---------------------------//
+// Include end
+//---------------------------//
+
+
+
+//---------------------------//
+// Define begin
+//---------------------------//
+#define TEST_HALF 8U
+#define TEST_TICKS 1200U
+
+#if defined(LED_WAVEFORM_USE) && (LED_WAVEFORM_TICKS != (2 * TEST_HALF))
+#error "test schedule expects LED_WAVEFORM_TICKS of 2 * TEST_HALF"
+#endif
+//---------------------------//
+// Define end
+//---------------------------//
+
+
+
+//---------------------------//
+// Typedef begin
+//---------------------------//
+struct test_call {
+	uint32_t half;			// Call shows from tick TEST_HALF * half + 1, 2 or more
+	void (*call)(void);
+};
+//---------------------------//
+// Typedef end
+//---------------------------//
+
+
+
+//---------------------------//
+// Prototypes begin
+//---------------------------//
+static void test_blink(void);
+static void test_pulse(void);
+static void test_blink_n(void);
+static void test_on(void);
+static void test_off(void);
+static void test_all_blink(void);
+static void test_force_off(void);
+static void test_all_pulse(void);
+//---------------------------//
+// Prototypes end
+//---------------------------//
+
+
+
+//---------------------------//
+// Variable begin
+//---------------------------//
+static const struct test_call test_calls[] = {
+	{2, test_blink},
+	{2, test_pulse},
+	{5, test_blink_n},
+	{9, test_on},
+	{12, test_off},
+	{12, test_pulse},
+	{20, test_all_blink},
+	{31, test_force_off},
+	{44, test_all_pulse},
+	{45, test_blink_n},
+	{70, test_blink},
+	{71, test_on},
+};
+//---------------------------//
+// Variable end
+//---------------------------//
+
+
+
+/**
+ * @fn int main(void)
+ * @brief Runs schedule and prints one line of LED levels per tick
+ * 
+ * @return (int) 1 if a half was written while being played out
+ */
+int main(void) {
+	host_reset();
+	user_io_init();
+	
+	for (uint32_t tick = 0; tick <= TEST_TICKS; tick++) {
+		if (tick) {
+#ifdef LED_WAVEFORM_USE
+			host_dma_tick();
+#endif
+			user_io_irq_handler();
+			printf("%lu %u%u%u\n", (unsigned long) tick, host_pin[LED0_PIN], host_pin[LED1_PIN], host_pin[LED2_PIN]);
+		}
+		
+		for (size_t i = 0; i < (sizeof(test_calls) / sizeof(test_calls[0])); i++) {
+#ifdef LED_WAVEFORM_USE
+			uint32_t after = (TEST_HALF * (test_calls[i].half - 1U)) - 1U;
+#else
+			uint32_t after = TEST_HALF * test_calls[i].half;
+#endif
+			if (after == tick) {
+				test_calls[i].call();
+			}
+		}
+	}
+	
+#ifdef LED_WAVEFORM_USE
+	if (host_dma_overwrites()) {
+		fprintf(stderr, "%lu words written while played out\n", (unsigned long) host_dma_overwrites());
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+
+
+static void test_blink(void) {
+	led_blink_infinite(LED0, 50);
+}
+
+
+
+static void test_pulse(void) {
+	led_pulse(LED1, 70);
+}
+
+
+
+static void test_blink_n(void) {
+	led_blink_n_times(LED2, 30, 3);
+}
+
+
+
+static void test_on(void) {
+	led_on(LED1);
+}
+
+
+
+static void test_off(void) {
+	led_off(LED0);
+}
+
+
+
+static void test_all_blink(void) {
+	led_all_blink_ms(40, 300);
+}
+
+
+
+static void test_force_off(void) {
+	led_force_off(LED2);
+}
+
+
+
+static void test_all_pulse(void) {
+	led_all_pulse(120);
+}
@@ -31,11 +31,99 @@
 
 
 
+//---------------------------//
+// Typedef begin
+//---------------------------//
+// Index type wide enough for every configured amount, loops over 256 or more objects need 16 bits
+#if (BTNS_AMOUNT > 0xFFFF) || (LEDS_AMOUNT > 0xFFFF) || (INTERVALS_AMOUNT > 0xFFFF) || (ENCODERS_AMOUNT > 0xFFFF) || (TASKS_AMOUNT > 0xFFFF)
+#error "Amounts over 65535 are not supported"
+#elif (BTNS_AMOUNT > 0xFF) || (LEDS_AMOUNT > 0xFF) || (INTERVALS_AMOUNT > 0xFF) || (ENCODERS_AMOUNT > 0xFF) || (TASKS_AMOUNT > 0xFF)
+typedef uint16_t user_io_id_t;
+#else
+typedef uint8_t user_io_id_t;
+#endif
+//---------------------------//
+// Typedef end
+//---------------------------//
+
+
+
+//---------------------------//
+// Define begin
+//---------------------------//
+#ifdef TASKS_USE
+// Task body resumes at the line it last waited on, locals don't keep their value across waits
+#define TASK_BEGIN(id) switch (task_resume_point(id)) { case 0:
+#define TASK_END(id) } return true
+
+#define TASK_YIELD(id) do { task_yield((id), __LINE__); return false; case __LINE__:; } while (0)
+#define TASK_WAIT_MS(id, ms) do { task_wait_ms((id), (ms), __LINE__); return false; case __LINE__:; } while (0)
+#endif
+
+
+
+#if defined(TASKS_USE) && defined(BTNS_USE)
+#define TASK_WAIT_CLICK(id, btn_id) do { task_wait_click((id), (btn_id), __LINE__); return false; case __LINE__:; } while (0)
+#endif
+
+
+
+#if defined(TASKS_USE) && defined(LEDS_USE) && !defined(LED_WAVEFORM_USE)
+#define TASK_WAIT_LED_DONE(id, led_id) do { task_wait_led_done((id), (led_id), __LINE__); return false; case __LINE__:; } while (0)
+#endif
+
+
+
+#ifdef USER_IO_EXPANDER_USE
+// Expander pin number used by expander_pin_read() and friends
+#define EXPANDER_PIN(port, bit) ((uint8_t) (((port) << 3) | (bit)))
+#endif
+//---------------------------//
+// Define end
+//---------------------------//
+
+
+
 //---------------------------//
 // Prototypes begin
 //---------------------------//
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
 void user_io_init(void);
 void user_io_irq_handler(void);
+void user_io_handler_elapsed(uint32_t ticks);
+
+
+
+#ifdef USER_IO_RETAIN_USE
+uint32_t user_io_retain_size(void);
+bool user_io_save(void *block, uint32_t size);
+bool user_io_resume(const void *block, uint32_t size);
+#endif
+
+
+
+#ifdef USER_IO_OVERRUN_USE
+uint32_t user_io_overruns(void);
+uint32_t user_io_missed_ticks(void);
+uint32_t user_io_handler_max_us(void);
+bool user_io_overloaded(void);
+#endif
+
+
+
+#ifdef USER_IO_EXPANDER_USE
+bool expander_pin_read(uint8_t pin);
+uint8_t expander_port_read(uint8_t port);
+void expander_pin_write(uint8_t pin, bool high);
+void expander_pin_toggle(uint8_t pin);
+void expander_transfer_done(bool ok);
+uint32_t expander_errors(void);
+#endif
 
 
 
@@ -52,6 +140,45 @@ bool btn_click(enum btn_id id);
 bool btn_released(enum btn_id id);
 bool btn_depressed(enum btn_id id);
 bool btns_no_input_ms(uint32_t idle_ms);
+
+bool btn_next_click(enum btn_id *id);
+bool btn_next_release(enum btn_id *id);
+uint32_t btn_click_mask(uint16_t word);
+uint32_t btn_release_mask(uint16_t word);
+#endif
+
+
+
+#if defined(BTNS_USE) && defined(USER_IO_OS_USE)
+uint32_t btn_wait_event(uint32_t mask, uint32_t timeout_ms);
+#endif
+
+
+
+#ifdef BTN_HOLD_EVENTS_USE
+void btn_hold_thresholds_set(enum btn_id id, const uint16_t *thresholds_ms, uint8_t n);
+uint8_t btn_hold_event(enum btn_id id);
+uint8_t btn_next_hold_event(enum btn_id *id);
+#endif
+
+
+
+#ifdef BTN_TIMESTAMPS_USE
+uint32_t btn_press_us(enum btn_id id);
+uint32_t btn_release_us(enum btn_id id);
+#endif
+
+
+
+#ifdef BTN_TIMESTAMPS_EXTI_USE
+void btn_edge_irq(enum btn_id id);
+#endif
+
+
+
+#ifdef BINDINGS_USE
+void binding_set(uint8_t slot, enum binding_source source, uint16_t input, enum led_id led_id, enum binding_effect effect, uint16_t arg_ms);
+void binding_clear(uint8_t slot);
 #endif
 
 
@@ -76,9 +203,105 @@ void led_all_pulse(uint16_t pulse_duration_ms);
 
 
 
+#ifdef LED_QUEUE_USE
+uint32_t leds_queue_dropped(void);
+#endif
+
+
+
+#ifdef LED_STATS_USE
+uint32_t led_on_time_ms(enum led_id id);
+uint32_t led_changes(enum led_id id);
+uint32_t led_charge_uah(enum led_id id);
+uint32_t leds_charge_uah(void);
+void led_stats_reset(enum led_id id);
+#endif
+
+
+
+#ifdef LED_RGB_USE
+void led_color(enum led_id id, uint8_t r, uint8_t g, uint8_t b);
+void led_all_color(uint8_t r, uint8_t g, uint8_t b);
+void led_rgb_transfer_done(void);
+#endif
+
+
+
+#ifdef LED_WAVEFORM_USE
+void led_waveform_half_done(void);
+#endif
+
+
+
+#ifdef LED_MATRIX_USE
+void led_matrix_scan(void);
+#endif
+
+
+
 #ifdef INTERVALS_USE
 bool interval_reached_ms(enum interval_id id, uint32_t ms);
 #endif
+
+
+
+#ifdef INTERVALS_DRIFT_FREE_USE
+uint32_t interval_periods_ms(enum interval_id id, uint32_t ms);
+#endif
+
+
+
+#if defined(INTERVALS_USE) && defined(USER_IO_OS_USE)
+void interval_wait(enum interval_id id, uint32_t ms);
+#endif
+
+
+
+#ifdef INTERVALS_STAGGER_USE
+uint8_t intervals_max_due(void);
+#endif
+
+
+
+#ifdef ENCODERS_USE
+void encoders_sample(void);
+int32_t encoder_read_delta(enum encoder_id id, int16_t *velocity);
+#endif
+
+
+
+#ifdef TASKS_USE
+void task_start(enum task_id id, bool (*fn)(enum task_id id));
+void task_stop(enum task_id id);
+bool task_running(enum task_id id);
+void tasks_run(void);
+#ifdef USER_IO_RETAIN_USE
+void task_attach(enum task_id id, bool (*fn)(enum task_id id));
+#endif
+
+// Used by TASK_x macros
+uint16_t task_resume_point(enum task_id id);
+void task_yield(enum task_id id, uint16_t line);
+void task_wait_ms(enum task_id id, uint32_t ms, uint16_t line);
+#endif
+
+
+
+#if defined(TASKS_USE) && defined(BTNS_USE)
+void task_wait_click(enum task_id id, enum btn_id btn_id, uint16_t line);
+#endif
+
+
+
+#if defined(TASKS_USE) && defined(LEDS_USE) && !defined(LED_WAVEFORM_USE)
+void task_wait_led_done(enum task_id id, enum led_id led_id, uint16_t line);
+#endif
+
+
+
+#ifdef __cplusplus
+}
+#endif
 //---------------------------//
 // Prototypes end
 //---------------------------//
@@ -0,0 +1,473 @@
+/**
+ *
+ * @file user_io.hpp
+ * @version 1.1.0
+ *
+ * ------------------------------
+ *
+ * @author https://github.com/AJ747
+ * @date Jul 12, 2025
+ *
+ * ------------------------------
+ *
+ * @brief C++17 front-end, generates switch, button and LED driver hooks from a pin map known at compile time
+ *
+ * @note Only the hooks are generated, the handler in user_io.c is not. It still walks ids at run time
+ * and calls each hook through extern "C", a hook picks its pin with a compare per id like the switch
+ * in user_io_driver.c would. Pins are inlined and pin maps are validated at compile time
+ *
+ */
+
+#ifndef USER_IO_INC_USER_IO_HPP_
+#define USER_IO_INC_USER_IO_HPP_
+
+
+
+//---------------------------//
+// Include begin
+//---------------------------//
+#include <stdint.h>
+#include <stddef.h>
+#include <type_traits>
+#include <utility>
+#include "user_io.h"
+#include "user_io_driver.h"
+//---------------------------//
+// Include end
+//---------------------------//
+
+
+
+//---------------------------//
+// Define begin
+//---------------------------//
+#if __cplusplus < 201703L
+#error "user_io.hpp needs C++17"
+#endif
+
+#ifndef USER_IO_CPP_DRIVER_USE
+#error "Uncomment USER_IO_CPP_DRIVER_USE in user_io_config.h so user_io_driver.c leaves these hooks out"
+#endif
+
+#if defined(USER_IO_LINUX_USE) || defined(LED_MATRIX_USE)
+#error "C++ pin map is not supported with USER_IO_LINUX_USE or LED_MATRIX_USE"
+#endif
+
+
+
+#ifdef SWITCHES_USE
+#define USER_IO_PANEL_SWITCHES(panel) \
+	extern "C" void switch_pins_init(void) { panel::switches::init(); } \
+	extern "C" enum switch_state switch_get_state(enum switch_id id) { return panel::switches::on((uint16_t) id)? SWITCH_ON : SWITCH_OFF; }
+#else
+#define USER_IO_PANEL_SWITCHES(panel)
+#endif
+
+
+
+#ifdef BTNS_USE
+#define USER_IO_PANEL_BTNS(panel) \
+	extern "C" void btn_pins_init(void) { panel::btns::init(); } \
+	extern "C" enum btn_state btn_get_state(enum btn_id id) { return panel::btns::pressed((uint16_t) id)? BTN_PRESSED : BTN_DEPRESSED; }
+#else
+#define USER_IO_PANEL_BTNS(panel)
+#endif
+
+
+
+#if defined(BTNS_USE) && defined(USER_IO_SPARSE_USE)
+#define USER_IO_PANEL_BTNS_PRESSED(panel) \
+	extern "C" uint32_t btns_get_pressed(uint16_t word) { return panel::btns::pressed_word(word); }
+#else
+#define USER_IO_PANEL_BTNS_PRESSED(panel)
+#endif
+
+
+
+#ifdef LEDS_USE
+#define USER_IO_PANEL_LEDS(panel) \
+	extern "C" void led_pins_init(void) { panel::leds::init(); } \
+	extern "C" void led_driver_on(enum led_id id) { panel::leds::on((uint16_t) id); } \
+	extern "C" void led_driver_off(enum led_id id) { panel::leds::off((uint16_t) id); } \
+	extern "C" void led_driver_toggle(enum led_id id) { panel::leds::toggle((uint16_t) id); }
+#else
+#define USER_IO_PANEL_LEDS(panel)
+#endif
+
+
+
+// Defines driver hooks of switches, buttons and LEDs in panel, use once at file scope in one .cpp file
+#define USER_IO_PANEL(panel) \
+	USER_IO_PANEL_SWITCHES(panel) \
+	USER_IO_PANEL_BTNS(panel) \
+	USER_IO_PANEL_BTNS_PRESSED(panel) \
+	USER_IO_PANEL_LEDS(panel) \
+	static_assert(true, "")
+//---------------------------//
+// Define end
+//---------------------------//
+
+
+
+namespace user_io {
+
+//---------------------------//
+// Typedef begin
+//---------------------------//
+enum class Polarity : uint8_t {
+	ACTIVE_LOW = 0,
+	ACTIVE_HIGH
+};
+
+
+
+/**
+ * @brief Pins of the MCU, through PIN_CONFIG() and friends of the board header
+ *
+ * @note Any type with these static members can be passed as Port, for pins behind other drivers
+ */
+struct GpioPort {
+	template <auto Pin, auto Mode>
+	static inline void config() {
+		PIN_CONFIG(Pin, Mode);
+	}
+
+	template <auto Pin>
+	static inline bool read() {
+		return PIN_READ(Pin) != 0;
+	}
+
+	template <auto Pin>
+	static inline void high() {
+		PIN_HIGH(Pin);
+	}
+
+	template <auto Pin>
+	static inline void low() {
+		PIN_LOW(Pin);
+	}
+
+	template <auto Pin>
+	static inline void toggle() {
+		PIN_TOGGLE(Pin);
+	}
+};
+
+
+
+#ifdef USER_IO_EXPANDER_USE
+/**
+ * @brief Pins of the I/O expander, pin is EXPANDER_PIN(port, bit)
+ *
+ * @note Directions and pull-ups are set once by expander_bus_init(), config does nothing
+ */
+struct ExpanderPort {
+	template <auto Pin, auto Mode>
+	static inline void config() {
+	}
+
+	template <auto Pin>
+	static inline bool read() {
+		return expander_pin_read(Pin);
+	}
+
+	template <auto Pin>
+	static inline void high() {
+		expander_pin_write(Pin, true);
+	}
+
+	template <auto Pin>
+	static inline void low() {
+		expander_pin_write(Pin, false);
+	}
+
+	template <auto Pin>
+	static inline void toggle() {
+		expander_pin_toggle(Pin);
+	}
+};
+#endif
+
+
+
+/**
+ * @brief Input on a fixed pin, read without dispatch
+ *
+ * @tparam Port backend of pin, GpioPort or ExpanderPort
+ * @tparam Pin pin as taken by Port, an integer or enum constant
+ * @tparam P level of pin while active
+ * @tparam Mode pin mode passed to Port
+ */
+template <typename Port, auto Pin, Polarity P = Polarity::ACTIVE_LOW, auto Mode = INPUT_PULL_UP>
+struct Input {
+	using port = Port;
+	static constexpr auto pin = Pin;
+
+	static inline void init() {
+		Port::template config<Pin, Mode>();
+	}
+
+	static inline bool active() {
+		return Port::template read<Pin>() == (P == Polarity::ACTIVE_HIGH);
+	}
+};
+
+template <typename Port, auto Pin, Polarity P = Polarity::ACTIVE_LOW, auto Mode = INPUT_PULL_UP>
+using Switch = Input<Port, Pin, P, Mode>;
+
+template <typename Port, auto Pin, Polarity P = Polarity::ACTIVE_LOW, auto Mode = INPUT_PULL_UP>
+using Button = Input<Port, Pin, P, Mode>;
+
+
+
+/**
+ * @brief LED on a fixed pin, driven without dispatch
+ *
+ * @tparam Port backend of pin, GpioPort or ExpanderPort
+ * @tparam Pin pin as taken by Port, an integer or enum constant
+ * @tparam P level of pin while lit
+ */
+template <typename Port, auto Pin, Polarity P = Polarity::ACTIVE_HIGH>
+struct Led {
+	using port = Port;
+	static constexpr auto pin = Pin;
+
+	static inline void init() {
+		Port::template config<Pin, OUTPUT>();
+		off();
+	}
+
+	static inline void on() {
+		if constexpr (P == Polarity::ACTIVE_HIGH) {
+			Port::template high<Pin>();
+		} else {
+			Port::template low<Pin>();
+		}
+	}
+
+	static inline void off() {
+		if constexpr (P == Polarity::ACTIVE_HIGH) {
+			Port::template low<Pin>();
+		} else {
+			Port::template high<Pin>();
+		}
+	}
+
+	static inline void toggle() {
+		Port::template toggle<Pin>();
+	}
+};
+
+
+
+/**
+ * @brief Inputs in enum order, base of Switches and Buttons
+ *
+ * @note Each call unrolls to a compare per input, like a switch over ids
+ */
+template <typename... Ins>
+struct Inputs {
+	static constexpr size_t amount = sizeof...(Ins);
+
+	static inline void init() {
+		(Ins::init(), ...);
+	}
+
+	static inline bool active(uint16_t id) {
+		return active(id, std::index_sequence_for<Ins...>{});
+	}
+
+	// Bit n is input word * 32 + n, all inputs of a word are read in one pass
+	static inline uint32_t active_word(uint16_t word) {
+		return active_word(word, std::index_sequence_for<Ins...>{});
+	}
+
+private:
+	template <size_t... I>
+	static inline bool active(uint16_t id, std::index_sequence<I...>) {
+		bool state = false;
+
+		(void) ((((id == I) && ((state = Ins::active()), true))) || ...);
+		return state;
+	}
+
+	template <size_t... I>
+	static inline uint32_t active_word(uint16_t word, std::index_sequence<I...>) {
+		uint32_t active = 0;
+
+		(void) word;
+		((active |= (((I >> 5) == word) && Ins::active())? ((uint32_t) 1U << (I & 31U)) : 0U), ...);
+		return active;
+	}
+};
+
+
+
+/**
+ * @brief Switches in enum switch_id order
+ *
+ */
+template <typename... Sws>
+struct Switches : Inputs<Sws...> {
+	static inline bool on(uint16_t id) {
+		return Inputs<Sws...>::active(id);
+	}
+};
+
+
+
+/**
+ * @brief Buttons in enum btn_id order
+ *
+ */
+template <typename... Btns>
+struct Buttons : Inputs<Btns...> {
+	static inline bool pressed(uint16_t id) {
+		return Inputs<Btns...>::active(id);
+	}
+
+	static inline uint32_t pressed_word(uint16_t word) {
+		return Inputs<Btns...>::active_word(word);
+	}
+};
+
+
+
+/**
+ * @brief LEDs in enum led_id order
+ *
+ */
+template <typename... Ls>
+struct Leds {
+	static constexpr size_t amount = sizeof...(Ls);
+
+	static inline void init() {
+		(Ls::init(), ...);
+	}
+
+	static inline void on(uint16_t id) {
+		on(id, std::index_sequence_for<Ls...>{});
+	}
+
+	static inline void off(uint16_t id) {
+		off(id, std::index_sequence_for<Ls...>{});
+	}
+
+	static inline void toggle(uint16_t id) {
+		toggle(id, std::index_sequence_for<Ls...>{});
+	}
+
+private:
+	template <size_t... I>
+	static inline void on(uint16_t id, std::index_sequence<I...>) {
+		(void) (((id == I) && (Ls::on(), true)) || ...);
+	}
+
+	template <size_t... I>
+	static inline void off(uint16_t id, std::index_sequence<I...>) {
+		(void) (((id == I) && (Ls::off(), true)) || ...);
+	}
+
+	template <size_t... I>
+	static inline void toggle(uint16_t id, std::index_sequence<I...>) {
+		(void) (((id == I) && (Ls::toggle(), true)) || ...);
+	}
+};
+
+
+
+// Common type of two pins, if they have one
+template <typename A, typename B, typename = void>
+struct pins_common {
+	static constexpr bool exists = false;
+};
+
+template <typename A, typename B>
+struct pins_common<A, B, std::void_t<std::common_type_t<A, B>>> {
+	static constexpr bool exists = true;
+	using type = std::common_type_t<A, B>;
+};
+
+
+
+/**
+ * @brief Checks if two objects sit on the same pin of the same port
+ *
+ * @return (bool)
+ */
+template <typename A, typename B>
+constexpr bool pin_shared() {
+	using a_pin = std::remove_cv_t<decltype(A::pin)>;
+	using b_pin = std::remove_cv_t<decltype(B::pin)>;
+
+	if constexpr (!std::is_same_v<typename A::port, typename B::port> || !pins_common<a_pin, b_pin>::exists) {
+		return false;
+	} else {
+		using common = typename pins_common<a_pin, b_pin>::type;
+
+		return static_cast<common>(A::pin) == static_cast<common>(B::pin);
+	}
+}
+
+
+
+template <typename First, typename... Rest>
+constexpr bool pins_unique_from();
+
+
+
+/**
+ * @brief Checks that no pin of a port is used twice
+ *
+ * @return (bool)
+ */
+template <typename... Objs>
+constexpr bool pins_unique() {
+	if constexpr (sizeof...(Objs) < 2) {
+		return true;
+	} else {
+		return pins_unique_from<Objs...>();
+	}
+}
+
+template <typename First, typename... Rest>
+constexpr bool pins_unique_from() {
+	return (!pin_shared<First, Rest>() && ...) && pins_unique<Rest...>();
+}
+
+
+
+template <typename B, typename L, typename S = Switches<>>
+struct Panel;
+
+/**
+ * @brief Pin map of all buttons, LEDs and switches, validated against user_io_config.h at compile time
+ *
+ * @note Pass to USER_IO_PANEL() to define driver hooks. Switches can be left out without SWITCHES_USE
+ */
+template <typename... Btns, typename... Ls, typename... Sws>
+struct Panel<Buttons<Btns...>, Leds<Ls...>, Switches<Sws...>> {
+	using btns = Buttons<Btns...>;
+	using leds = Leds<Ls...>;
+	using switches = Switches<Sws...>;
+
+#ifdef SWITCHES_USE
+	static_assert(switches::amount > 0, "Panel needs Switches in enum switch_id order with SWITCHES_USE");
+#endif
+#ifdef BTNS_USE
+	static_assert(btns::amount == BTNS_AMOUNT, "Panel needs one Button per enum btn_id");
+#endif
+#ifdef LEDS_USE
+	static_assert(leds::amount == LEDS_AMOUNT, "Panel needs one Led per enum led_id");
+#endif
+	static_assert(pins_unique<Sws..., Btns..., Ls...>(), "Pin used twice in Panel");
+};
+//---------------------------//
+// Typedef end
+//---------------------------//
+
+} /* namespace user_io */
+
+
+
+#endif /* USER_IO_INC_USER_IO_HPP_ */
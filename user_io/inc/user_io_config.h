@@ -27,11 +27,98 @@
 
 
 
+/// Uncomment to measure the handler and shed LED work when it runs over budget
+//#define USER_IO_OVERRUN_USE // <-- EDIT HERE
+
+#ifdef USER_IO_OVERRUN_USE
+// Time handler may take, defaults to a full period
+#define USER_IO_OVERRUN_BUDGET_US (USER_IO_HANDLER_PERIOD_MS * 1000U) // <-- EDIT HERE
+
+// LEDs updated per tick while overloaded, others catch up on their turn
+#define USER_IO_SHED_LEDS_PER_TICK 1 // <-- EDIT HERE
+
+// Ticks within budget before leaving overloaded mode
+#define USER_IO_SHED_RECOVER_TICKS 100 // <-- EDIT HERE
+#endif
+
+
+
+/// Uncomment to save state into retained RAM before sleep and resume it after wake
+//#define USER_IO_RETAIN_USE // <-- EDIT HERE
+
+
+
+/// Uncomment to only update LEDs and buttons that are doing something, for large amounts
+//#define USER_IO_SPARSE_USE // <-- EDIT HERE
+
+
+
+/// Uncomment if buttons, switches or LEDs sit on an I2C/SPI I/O expander, see expander_pin_read()
+//#define USER_IO_EXPANDER_USE // <-- EDIT HERE
+
+#ifdef USER_IO_EXPANDER_USE
+// 8 bit ports, MCP23017 has 2
+#define EXPANDER_PORTS 2 // <-- EDIT HERE
+
+// First input port and first output latch register, ports are consecutive registers
+#define EXPANDER_INPUT_REG 0x12 // <-- EDIT HERE
+#define EXPANDER_OUTPUT_REG 0x14 // <-- EDIT HERE
+
+// Input levels assumed until first read completes, 0xFF if inputs are pulled up
+#define EXPANDER_INPUT_IDLE 0xFF // <-- EDIT HERE
+#endif
+
+
+
+/// Uncomment to use blocking wait API in RTOS/threaded builds
+//#define USER_IO_OS_USE // <-- EDIT HERE
+
+#ifdef USER_IO_OS_USE
+// OS backend, FreeRTOS unless USER_IO_OS_PTHREAD is defined here or by the build
+//#define USER_IO_OS_PTHREAD // <-- EDIT HERE
+#ifndef USER_IO_OS_PTHREAD
+#define USER_IO_OS_FREERTOS
+#endif
+
+#define USER_IO_WAIT_FOREVER 0xFFFFFFFFU
+#endif
+
+
+
+/// Uncomment to run on Linux userspace, see user_io_linux.h
+//#define USER_IO_LINUX_USE // <-- EDIT HERE
+
+#ifdef USER_IO_LINUX_USE
+// Uncomment to simulate pins through pipes instead of a GPIO chip
+//#define USER_IO_LINUX_SIM_PINS // <-- EDIT HERE
+
+#define USER_IO_LINUX_GPIOCHIP "/dev/gpiochip0" // <-- EDIT HERE
+
+// Line offsets, in enum order
+#define USER_IO_LINUX_SWITCH_LINES {5, 6} // <-- EDIT HERE
+#define USER_IO_LINUX_BTN_LINES {17, 27, 22} // <-- EDIT HERE
+#define USER_IO_LINUX_LED_LINES {23, 24, 25} // <-- EDIT HERE
+
+// Comment if inputs are active high or have external pull-ups
+#define USER_IO_LINUX_INPUT_ACTIVE_LOW // <-- EDIT HERE
+#define USER_IO_LINUX_INPUT_PULL_UP // <-- EDIT HERE
+#endif
+
+
+
+/// Uncomment to generate switch, button and LED driver hooks from a C++ pin map, see user_io.hpp
+//#define USER_IO_CPP_DRIVER_USE // <-- EDIT HERE
+
+
+
 // Comment if feature is not needed
 #define SWITCHES_USE  // <-- EDIT HERE
 #define BTNS_USE // <-- EDIT HERE
 #define LEDS_USE // <-- EDIT HERE
 #define INTERVALS_USE // <-- EDIT HERE
+//#define ENCODERS_USE // <-- EDIT HERE
+//#define TASKS_USE // <-- EDIT HERE
+//#define BINDINGS_USE // <-- EDIT HERE
 
 
 
@@ -44,18 +131,191 @@
 // Button sampling time, alter if faster clicking is required
 #define BTN_DEBOUNCE_TRESHOLD_MS 20	// <-- EDIT HERE
 #define BTNS_AMOUNT	3 // <-- EDIT HERE
+
+// Uncomment to use hold thresholds that fire once per press
+//#define BTN_HOLD_EVENTS_USE // <-- EDIT HERE
+
+// Uncomment if buttons share ADC channels on resistor ladders
+//#define BTN_LADDER_USE // <-- EDIT HERE
+
+// Uncomment one to replace sampling window debounce
+// Eager registers press on first pressed sample, release after BTN_DEBOUNCE_TRESHOLD_MS
+//#define BTN_DEBOUNCE_EAGER_USE // <-- EDIT HERE
+// Integrator counts samples up to press and down to release threshold
+//#define BTN_DEBOUNCE_INTEGRATOR_USE // <-- EDIT HERE
+
+// Uncomment to timestamp raw button edges with user_io_timestamp_us()
+//#define BTN_TIMESTAMPS_USE // <-- EDIT HERE
+#endif
+
+
+
+#ifdef BTN_TIMESTAMPS_USE
+// Uncomment if btn_edge_irq() is called from EXTI callbacks, otherwise edges are timestamped at sampling
+//#define BTN_TIMESTAMPS_EXTI_USE // <-- EDIT HERE
+#endif
+
+
+
+#ifdef BTN_DEBOUNCE_INTEGRATOR_USE
+// Pressed samples to register press, released samples to register release
+#define BTN_DEBOUNCE_PRESS_MS 10 // <-- EDIT HERE
+#define BTN_DEBOUNCE_RELEASE_MS 30 // <-- EDIT HERE
+#endif
+
+
+
+#ifdef BTN_HOLD_EVENTS_USE
+// Max hold thresholds per button, up to 8
+#define BTN_HOLD_THRESHOLDS_MAX 4 // <-- EDIT HERE
+#endif
+
+
+
+#ifdef BTN_LADDER_USE
+// ADC channels read every tick
+#define BTN_LADDER_CHANNELS 1 // <-- EDIT HERE
+
+// Voltage bands, {channel, min ADC value, max ADC value, button}
+// Buttons not listed here are read from btn_get_state()
+#define BTN_LADDER_BANDS { \
+	{0, 0, 400, BTN0}, \
+	{0, 1600, 2400, BTN1}, \
+	{0, 2800, 3400, BTN2}, \
+} // <-- EDIT HERE
+
+// ADC counts a band is widened by on both sides once entered, keep below half the gap between bands
+#define BTN_LADDER_HYSTERESIS 50 // <-- EDIT HERE
 #endif
 
 
 
 #ifdef LEDS_USE
 #define LEDS_AMOUNT	3	// <-- EDIT HERE
+
+// Uncomment to render LED effects ahead into a buffer played out by DMA
+//#define LED_WAVEFORM_USE // <-- EDIT HERE
+
+// Uncomment if LEDs are a chain of addressable RGB LEDs (WS2812-class), LEDx is pixel x
+//#define LED_RGB_USE // <-- EDIT HERE
+
+// Uncomment to count on-time and state changes per LED
+//#define LED_STATS_USE // <-- EDIT HERE
+
+// Uncomment if LEDs are a row/column matrix or charlieplexed, scanned one row at a time
+//#define LED_MATRIX_USE // <-- EDIT HERE
+
+// Uncomment to limit LEDs lit at once, LEDs over budget take turns every tick
+//#define LED_BUDGET_USE // <-- EDIT HERE
+
+// Uncomment to queue LED effect calls from main loop, handler applies them whole at next tick
+//#define LED_QUEUE_USE // <-- EDIT HERE
+#endif
+
+
+
+#ifdef LED_QUEUE_USE
+// Effect calls between two ticks, all-LED calls take one, power of 2 up to 128
+#define LED_QUEUE_SIZE 16 // <-- EDIT HERE
+#endif
+
+
+
+#ifdef LED_BUDGET_USE
+// Turns are one tick, with n groups taking turns each LED is lit every n * USER_IO_HANDLER_PERIOD_MS.
+// Keep that at 10 ms or less to not flicker, 5 ms handler for two groups
+// Uncomment one, max LEDs lit at once or max total current of LEDs lit at once in uA.
+// An LED drawing more than LED_BUDGET_UA by itself is never lit
+#define LED_BUDGET_MAX_ON 2 // <-- EDIT HERE
+//#define LED_BUDGET_UA 4000 // <-- EDIT HERE
+#endif
+
+
+
+#ifdef LED_WAVEFORM_USE
+// Ticks in buffer played out in a loop, 4 bytes per tick. Even, halves are rendered in turns.
+// Effect changes show after LED_WAVEFORM_TICKS / 2 to LED_WAVEFORM_TICKS ticks
+#define LED_WAVEFORM_TICKS 16 // <-- EDIT HERE
+#endif
+
+
+
+#ifdef LED_RGB_USE
+// Color used by effects until led_color() is called, 0xRRGGBB
+#define LED_RGB_DEFAULT_COLOR 0x202020 // <-- EDIT HERE
+#endif
+
+
+
+#ifdef LED_MATRIX_USE
+// Rows are scanned one at a time, up to 32 columns are driven together
+#define LED_MATRIX_ROWS 2 // <-- EDIT HERE
+#define LED_MATRIX_COLS 2 // <-- EDIT HERE
+
+// Row and column of each LED, in enum order. Rows without LEDs aren't scanned.
+// LED_MATRIX_AT() fails to compile on a position out of range, or on row equal to column if charlieplexed
+#define LED_MATRIX_MAP {LED_MATRIX_AT(0, 0), LED_MATRIX_AT(0, 1), LED_MATRIX_AT(1, 0)} // <-- EDIT HERE
+
+// Uncomment if LEDs are charlieplexed, LED at row r and column c sits between pins r and c
+//#define LED_MATRIX_CHARLIEPLEX // <-- EDIT HERE
+
+// Uncomment if led_matrix_scan() is called from a faster timer instead of the handler
+//#define LED_MATRIX_EXTERNAL_SCAN // <-- EDIT HERE
+#endif
+
+
+
+#if defined(LED_STATS_USE) || defined(LED_BUDGET_UA)
+// Current drawn by each LED when on in uA, in enum order
+#define LED_CURRENT_UA {2000, 2000, 2000} // <-- EDIT HERE
 #endif
 
 
 
 #ifdef INTERVALS_USE
 #define INTERVALS_AMOUNT 3	// <-- EDIT HERE
+
+// Uncomment to spread intervals with equal or harmonic periods over different ticks
+//#define INTERVALS_STAGGER_USE // <-- EDIT HERE
+#ifdef INTERVALS_STAGGER_USE
+// Phases tried when an interval is placed, each tried against every other interval
+#define INTERVALS_STAGGER_CANDIDATES 256 // <-- EDIT HERE
+#endif
+
+// Uncomment to move deadlines by whole periods when reached, late checks don't add up
+//#define INTERVALS_DRIFT_FREE_USE // <-- EDIT HERE
+#endif
+
+
+
+#ifdef ENCODERS_USE
+#define ENCODERS_AMOUNT 1 // <-- EDIT HERE
+
+// Quadrature steps per detent, usually 4 or 2
+#define ENCODER_STEPS_PER_DETENT 4 // <-- EDIT HERE
+
+// Time velocity is measured over
+#define ENCODER_VELOCITY_WINDOW_MS 100 // <-- EDIT HERE
+
+// Uncomment if encoders_sample() is called from a faster timer instead of the handler
+//#define ENCODERS_EXTERNAL_SAMPLE // <-- EDIT HERE
+#endif
+
+
+
+#ifdef TASKS_USE
+// Cooperative tasks run by tasks_run(), see TASK_BEGIN() in user_io.h
+#define TASKS_AMOUNT 2 // <-- EDIT HERE
+#endif
+
+
+
+#ifdef BINDINGS_USE
+// Button and switch to LED rules evaluated inside the handler, see binding_set()
+#define BINDINGS_AMOUNT 4 // <-- EDIT HERE
+
+// Uncomment to load rules at init, {source, input, led, effect, arg_ms} per rule
+//#define BINDINGS_TABLE {{BINDING_BTN_HELD, BTN0, LED0, BINDING_LED_ON, 0}} // <-- EDIT HERE
 #endif
 //---------------------------//
 // Define end
@@ -112,6 +372,43 @@ enum interval_id {
 	INTERVAL2, // <-- EDIT HERE
 };
 #endif
+
+
+
+#ifdef ENCODERS_USE
+enum encoder_id {
+	ENC0 = 0, // <-- EDIT HERE
+};
+#endif
+
+
+
+#ifdef TASKS_USE
+enum task_id {
+	TASK0 = 0, // <-- EDIT HERE
+	TASK1, // <-- EDIT HERE
+};
+#endif
+
+
+
+#ifdef BINDINGS_USE
+enum binding_source {
+	BINDING_NONE = 0,
+	BINDING_BTN_CLICK,
+	BINDING_BTN_RELEASE,
+	BINDING_BTN_HELD,
+	BINDING_SWITCH_ON,
+	BINDING_SWITCH_OFF
+};
+
+enum binding_effect {
+	BINDING_LED_ON = 0,
+	BINDING_LED_OFF,
+	BINDING_LED_PULSE,
+	BINDING_LED_BLINK
+};
+#endif
 //---------------------------//
 // Enum end
 //---------------------------//
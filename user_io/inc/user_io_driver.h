@@ -34,6 +34,33 @@
 //---------------------------//
 // Prototypes begin
 //---------------------------//
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#ifdef USER_IO_OS_USE
+void user_io_os_init(void);
+uint32_t user_io_os_wait(uint32_t bits, uint32_t timeout_ms);
+void user_io_os_clear(uint32_t bits);
+void user_io_os_signal(uint32_t bits);
+#endif
+
+
+
+#if defined(USER_IO_OVERRUN_USE) || defined(BTN_TIMESTAMPS_USE)
+uint32_t user_io_timestamp_us(void);
+#endif
+
+
+
+#ifdef USER_IO_RETAIN_USE
+void user_io_pins_resume(void);
+#endif
+
+
+
 #ifdef SWITCHES_USE
 void switch_pins_init(void);
 enum switch_state switch_get_state(enum switch_id id);
@@ -48,12 +75,64 @@ enum btn_state btn_get_state(enum btn_id id);
 
 
 
+#if defined(BTNS_USE) && defined(USER_IO_SPARSE_USE)
+uint32_t btns_get_pressed(uint16_t word);
+#endif
+
+
+
+#ifdef USER_IO_EXPANDER_USE
+void expander_bus_init(void);
+void expander_bus_read(uint8_t reg, uint8_t *data, uint8_t len);
+void expander_bus_write(uint8_t reg, const uint8_t *data, uint8_t len);
+#endif
+
+
+
+#ifdef BTN_LADDER_USE
+void btn_ladder_adc_init(void);
+void btn_ladder_get_samples(uint16_t *samples);
+#endif
+
+
+
+#ifdef ENCODERS_USE
+void encoder_pins_init(void);
+uint8_t encoder_get_ab(enum encoder_id id);
+#endif
+
+
+
 #ifdef LEDS_USE
 void led_pins_init(void);
 void led_driver_on(enum led_id id);
 void led_driver_off(enum led_id id);
 void led_driver_toggle(enum led_id id);
 #endif
+
+
+
+#ifdef LED_WAVEFORM_USE
+void led_driver_waveform_start(const uint32_t *words, uint16_t ticks);
+#endif
+
+
+
+#ifdef LED_MATRIX_USE
+void led_driver_matrix_row(uint8_t row, uint32_t columns);
+#endif
+
+
+
+#ifdef LED_RGB_USE
+void led_driver_rgb_transfer(const uint8_t *data, uint16_t len);
+#endif
+
+
+
+#ifdef __cplusplus
+}
+#endif
 //---------------------------//
 // Prototypes end
 //---------------------------//
@@ -0,0 +1,56 @@
+/**
+ *
+ * @file user_io_linux.h
+ * @version 1.1.0
+ *
+ * ------------------------------
+ *
+ * @author https://github.com/AJ747
+ * @date Jul 12, 2025
+ *
+ * ------------------------------
+ *
+ * @brief Linux userspace port header
+ *
+ */
+
+#ifndef USER_IO_INC_USER_IO_LINUX_H_
+#define USER_IO_INC_USER_IO_LINUX_H_
+
+
+
+//---------------------------//
+// Include begin
+//---------------------------//
+#include <stdint.h>
+#include <stdbool.h>
+#include "user_io_config.h"
+//---------------------------//
+// Include end
+//---------------------------//
+
+
+
+//---------------------------//
+// Prototypes begin
+//---------------------------//
+#ifdef USER_IO_LINUX_USE
+int user_io_linux_init(void);
+int user_io_linux_poll(int timeout_ms);
+int user_io_linux_fd(void);
+#endif
+
+
+
+#if defined(USER_IO_LINUX_USE) && defined(USER_IO_LINUX_SIM_PINS)
+void user_io_linux_sim_input(uint32_t line, bool active);
+bool user_io_linux_sim_output(uint32_t line);
+uint32_t user_io_linux_sim_output_writes(void);
+#endif
+//---------------------------//
+// Prototypes end
+//---------------------------//
+
+
+
+#endif /* USER_IO_INC_USER_IO_LINUX_H_ */
@@ -19,6 +19,7 @@
 //---------------------------//
 // Include begin
 //---------------------------//
+#include <string.h>
 #include "user_io.h"
 #include "user_io_driver.h"
 //---------------------------//
@@ -34,6 +35,248 @@
 #define BTNS_IDLE_MS_MAX (0xFFFFFFFFU - USER_IO_HANDLER_PERIOD_MS)
 #define BTN_DEBOUNCE_TRESHOLD (BTN_DEBOUNCE_TRESHOLD_MS / USER_IO_HANDLER_PERIOD_MS)
 #endif
+
+
+
+// Bitmaps of 32 bit words, set bits are walked lowest first
+#define USER_IO_BITMAP_WORDS(amount) (((amount) + 31U) / 32U)
+#define USER_IO_BIT_WORD(id) ((uint16_t) ((id) >> 5))
+#define USER_IO_BIT_MASK(id) ((uint32_t) 1U << ((id) & 31U))
+
+#if defined(__GNUC__) || defined(__clang__)
+#define USER_IO_CTZ(bits) ((uint8_t) __builtin_ctz(bits))
+#else
+#define USER_IO_CTZ(bits) user_io_ctz(bits)
+#define USER_IO_CTZ_PORTABLE
+#endif
+
+
+
+#if defined(LEDS_USE) && (defined(LED_RGB_USE) || defined(LED_STATS_USE) || defined(USER_IO_RETAIN_USE) || defined(LED_BUDGET_USE))
+#define LED_OUTPUT_TRACK_USE
+#endif
+
+
+
+#ifdef LED_BUDGET_USE
+#if defined(LED_WAVEFORM_USE) || defined(LED_RGB_USE) || defined(LED_MATRIX_USE)
+#error "LED_BUDGET_USE works with LEDs driven by led_driver_on() only"
+#endif
+
+#if defined(LED_BUDGET_UA) && defined(LED_BUDGET_MAX_ON)
+#error "Select only one of LED_BUDGET_UA and LED_BUDGET_MAX_ON"
+#elif defined(LED_BUDGET_UA)
+#define LED_BUDGET_LIMIT ((uint32_t) LED_BUDGET_UA)
+#define LED_BUDGET_COST(id) (led_current_ua[(id)])
+#else
+#if LED_BUDGET_MAX_ON < 1
+#error "LED_BUDGET_MAX_ON must be at least 1"
+#endif
+#define LED_BUDGET_LIMIT ((uint32_t) LED_BUDGET_MAX_ON)
+#define LED_BUDGET_COST(id) (1U)
+#endif
+#define LED_BUDGET_FITS(id) (LED_BUDGET_COST(id) <= LED_BUDGET_LIMIT) // LED fits in budget by itself
+#define LED_BUDGET_PHASES 2 // Blinks are on half of period, only two phases don't overlap
+#endif
+
+
+
+#if defined(BTNS_USE) && defined(USER_IO_SPARSE_USE)
+#define BTNS_SPARSE_USE
+#endif
+
+// Waveform replays all LEDs from window start, it keeps updating every LED
+#if defined(LEDS_USE) && defined(USER_IO_SPARSE_USE) && !defined(LED_WAVEFORM_USE)
+#define LEDS_SPARSE_USE
+#endif
+
+
+
+#ifdef USER_IO_EXPANDER_USE
+#if (EXPANDER_PORTS > 32)
+#error "EXPANDER_PORTS must be 32 or less"
+#endif
+
+// One transfer on the bus at a time
+#define EXPANDER_IDLE 0
+#define EXPANDER_READING 1
+#define EXPANDER_WRITING 2
+#endif
+
+
+
+#ifdef USER_IO_RETAIN_USE
+#define USER_IO_RETAIN_MAGIC 0x55494F52U
+#define USER_IO_RETAIN_FORMAT 1U // Bump when save or resume changes how regions are stored
+#endif
+
+
+
+#if defined(BINDINGS_USE) && !defined(LEDS_USE)
+#error "BINDINGS_USE requires LEDS_USE"
+#endif
+
+
+
+#if defined(BTN_DEBOUNCE_EAGER_USE) && defined(BTN_DEBOUNCE_INTEGRATOR_USE)
+#error "Select only one of BTN_DEBOUNCE_EAGER_USE and BTN_DEBOUNCE_INTEGRATOR_USE"
+#endif
+
+
+
+#if defined(BTNS_USE) && (defined(BTN_DEBOUNCE_EAGER_USE) || defined(BTN_DEBOUNCE_INTEGRATOR_USE))
+#define BTN_DEBOUNCE_POLICY_USE
+#endif
+
+
+
+#ifdef BTN_TIMESTAMPS_USE
+// Edges this soon after a debounced change are its bounces, a latched edge older than window never changed state
+#if defined(BTN_DEBOUNCE_INTEGRATOR_USE)
+#define BTN_EDGE_SETTLE_MS ((BTN_DEBOUNCE_PRESS_MS < BTN_DEBOUNCE_RELEASE_MS)? BTN_DEBOUNCE_PRESS_MS : BTN_DEBOUNCE_RELEASE_MS)
+#define BTN_EDGE_WINDOW_MS (2U * ((BTN_DEBOUNCE_PRESS_MS > BTN_DEBOUNCE_RELEASE_MS)? BTN_DEBOUNCE_PRESS_MS : BTN_DEBOUNCE_RELEASE_MS))
+#else
+#define BTN_EDGE_SETTLE_MS BTN_DEBOUNCE_TRESHOLD_MS
+#define BTN_EDGE_WINDOW_MS (2U * (BTN_DEBOUNCE_TRESHOLD_MS + USER_IO_HANDLER_PERIOD_MS))
+#endif
+#define BTN_EDGE_SETTLE_US ((uint32_t) BTN_EDGE_SETTLE_MS * 1000U)
+#define BTN_EDGE_WINDOW_US ((uint32_t) (BTN_EDGE_WINDOW_MS + USER_IO_HANDLER_PERIOD_MS) * 1000U)
+#endif
+
+
+
+#ifdef BTN_DEBOUNCE_INTEGRATOR_USE
+#define BTN_DEBOUNCE_PRESS ((BTN_DEBOUNCE_PRESS_MS < USER_IO_HANDLER_PERIOD_MS)? 1U : (BTN_DEBOUNCE_PRESS_MS / USER_IO_HANDLER_PERIOD_MS))
+#define BTN_DEBOUNCE_RELEASE ((BTN_DEBOUNCE_RELEASE_MS < USER_IO_HANDLER_PERIOD_MS)? 1U : (BTN_DEBOUNCE_RELEASE_MS / USER_IO_HANDLER_PERIOD_MS))
+
+#if (BTN_DEBOUNCE_PRESS_MS / USER_IO_HANDLER_PERIOD_MS > 0xFF) || (BTN_DEBOUNCE_RELEASE_MS / USER_IO_HANDLER_PERIOD_MS > 0xFF)
+#error "BTN_DEBOUNCE_PRESS_MS and BTN_DEBOUNCE_RELEASE_MS must be 255 ticks or less"
+#endif
+#endif
+
+
+
+#if defined(BTN_HOLD_EVENTS_USE) && (BTN_HOLD_THRESHOLDS_MAX > 8)
+#error "BTN_HOLD_THRESHOLDS_MAX must be 8 or less"
+#endif
+
+
+
+#ifdef USER_IO_OS_USE
+#ifdef BTNS_USE
+#define USER_IO_OS_BTNS_BITS BTNS_AMOUNT
+#else
+#define USER_IO_OS_BTNS_BITS 0
+#endif
+#ifdef INTERVALS_USE
+#define USER_IO_OS_INTERVALS_BITS INTERVALS_AMOUNT
+#else
+#define USER_IO_OS_INTERVALS_BITS 0
+#endif
+#if defined(USER_IO_OS_FREERTOS) && ((USER_IO_OS_BTNS_BITS + USER_IO_OS_INTERVALS_BITS) > 24)
+#error "USER_IO_OS_FREERTOS supports up to 24 buttons and intervals combined, event groups hold 24 bits"
+#elif (USER_IO_OS_BTNS_BITS + USER_IO_OS_INTERVALS_BITS) > 32
+#error "USER_IO_OS_USE supports up to 32 buttons and intervals combined"
+#endif
+#define USER_IO_OS_BTN_BIT(id) ((uint32_t) 1U << (id))
+#define USER_IO_OS_INTERVAL_BIT(id) ((uint32_t) 1U << (USER_IO_OS_BTNS_BITS + (id)))
+#endif
+
+
+
+#ifdef INTERVALS_STAGGER_USE
+#if INTERVALS_AMOUNT > 32
+#error "INTERVALS_STAGGER_USE supports up to 32 intervals"
+#endif
+#if (INTERVALS_STAGGER_CANDIDATES < 1) || (INTERVALS_STAGGER_CANDIDATES > 4096)
+#error "INTERVALS_STAGGER_CANDIDATES must be 1 to 4096"
+#endif
+#define INTERVALS_STAGGER_SCAN_TICKS 4096 // Longest repeat of due ticks scanned by intervals_max_due()
+#endif
+
+
+
+#if defined(USER_IO_OVERRUN_USE) && defined(LEDS_USE) && !defined(LED_WAVEFORM_USE)
+#define LEDS_SHED_USE // Waveform renders LEDs ahead, nothing to shed per tick
+#endif
+
+// Rules set effects from the handler, which may run while main loop is catching LEDs up to the current tick.
+// Queued effects and stats resets are applied by the handler too
+#if defined(BINDINGS_USE) && (defined(LED_WAVEFORM_USE) || defined(LEDS_SHED_USE)) && !defined(LED_QUEUE_USE)
+#error "BINDINGS_USE needs LED_QUEUE_USE to be used with LED_WAVEFORM_USE or USER_IO_OVERRUN_USE"
+#endif
+
+
+
+#ifdef LED_MATRIX_USE
+#if defined(LED_WAVEFORM_USE) || defined(LED_RGB_USE)
+#error "LED_MATRIX_USE can't be used with LED_WAVEFORM_USE or LED_RGB_USE"
+#endif
+#if LED_MATRIX_COLS > 32
+#error "LED_MATRIX_USE supports up to 32 columns"
+#endif
+#if (LED_MATRIX_ROWS < 1) || (LED_MATRIX_ROWS > 255)
+#error "LED_MATRIX_USE supports 1 to 255 rows"
+#endif
+#if defined(LED_MATRIX_CHARLIEPLEX) && (LED_MATRIX_ROWS != LED_MATRIX_COLS)
+#error "LED_MATRIX_CHARLIEPLEX needs LED_MATRIX_ROWS equal to LED_MATRIX_COLS, one per pin"
+#endif
+#define LED_MATRIX_BIT(id) ((uint32_t) 1U << led_matrix_pos[id].col)
+
+// Position in LED_MATRIX_MAP, a row or column out of range fails to compile on negative array size
+#ifdef LED_MATRIX_CHARLIEPLEX
+#define LED_MATRIX_POS_OK(row, col) (((row) < LED_MATRIX_ROWS) && ((col) < LED_MATRIX_COLS) && ((row) != (col)))
+#else
+#define LED_MATRIX_POS_OK(row, col) (((row) < LED_MATRIX_ROWS) && ((col) < LED_MATRIX_COLS))
+#endif
+#define LED_MATRIX_AT(row, col) {(uint8_t) ((row) + (0U * sizeof(char[LED_MATRIX_POS_OK(row, col)? 1 : -1]))), (uint8_t) (col)}
+#endif
+
+
+
+#ifdef BTN_LADDER_USE
+#define BTN_LADDER_BANDS_AMOUNT (sizeof(btn_ladder_band) / sizeof(btn_ladder_band[0]))
+#endif
+
+
+
+#ifdef LED_WAVEFORM_USE
+#if LEDS_AMOUNT > 16
+#error "LED_WAVEFORM_USE supports up to 16 LEDs, one set/reset word"
+#endif
+#if (LED_WAVEFORM_TICKS < 2) || (LED_WAVEFORM_TICKS % 2) || (LED_WAVEFORM_TICKS > 0xFFFF)
+#error "LED_WAVEFORM_TICKS must be even, two halves are played out in turns"
+#endif
+#define LED_WAVEFORM_HALF (LED_WAVEFORM_TICKS / 2)
+#define LED_WAVEFORM_SET(id) ((uint32_t) 1U << (id))
+#define LED_WAVEFORM_RESET(id) ((uint32_t) 1U << ((id) + 16))
+#endif
+
+
+
+#ifdef LEDS_USE
+#define LED_REQ_ALL ((user_io_id_t) ~0U) // Request applies to every LED, no LED has this id
+#endif
+
+
+
+#ifdef LED_QUEUE_USE
+#if (LED_QUEUE_SIZE > 128) || (LED_QUEUE_SIZE & (LED_QUEUE_SIZE - 1))
+#error "LED_QUEUE_SIZE must be a power of 2 up to 128"
+#endif
+#endif
+
+
+
+#ifdef LED_RGB_USE
+#ifdef LED_WAVEFORM_USE
+#error "LED_RGB_USE and LED_WAVEFORM_USE can't be used together"
+#endif
+#define LED_RGB_BYTES_PER_PIXEL 3
+#define LED_RGB_ENCODED_PER_BYTE 4 // Each color bit is sent as 4 bits, 1110 or 1000
+#define LED_RGB_FRAME_SIZE (LEDS_AMOUNT * LED_RGB_BYTES_PER_PIXEL)
+#define LED_RGB_ENCODED_SIZE (LED_RGB_FRAME_SIZE * LED_RGB_ENCODED_PER_BYTE)
+#endif
 //---------------------------//
 // Define end
 //---------------------------//
@@ -52,6 +295,31 @@ enum led_state {
 	BLINK_N_TIMES,
 	PULSE
 };
+
+
+
+enum led_request {
+	LED_REQ_OFF = 0,
+	LED_REQ_FORCE_OFF,
+	LED_REQ_ON,
+	LED_REQ_PULSE,
+	LED_REQ_BLINK_INFINITE,
+	LED_REQ_BLINK_MS,
+	LED_REQ_BLINK_N_TIMES,
+	LED_REQ_STATS_RESET // Applied by leds_queue_apply() only
+};
+#endif
+
+
+
+#ifdef TASKS_USE
+enum task_wait {
+	TASK_WAITING_NONE = 0,
+	TASK_WAITING_MS,
+	TASK_WAITING_CLICK,
+	TASK_WAITING_LED_DONE,
+	TASK_CLICKED			// Click seen by handler, taken by tasks_run() when task resumes
+};
 #endif
 //---------------------------//
 // Enum end
@@ -67,11 +335,115 @@ struct btn {
 	uint16_t hold_duration;
 	uint8_t debounce_counter;
 	uint8_t press_counter;
-	uint8_t click;
-	uint8_t released;
 	enum btn_state curr_state;
 	enum btn_state last_state;
 	enum btn_id id;
+#ifdef BTN_HOLD_EVENTS_USE
+	uint16_t hold_thresholds[BTN_HOLD_THRESHOLDS_MAX];
+	uint8_t hold_thresholds_amount;
+	uint8_t hold_next;
+#endif
+#ifdef BTN_LADDER_USE
+	bool on_ladder;
+	enum btn_state ladder_state;
+#endif
+#ifdef USER_IO_OS_USE
+	volatile bool os_waiting;
+#endif
+#ifdef BTN_TIMESTAMPS_USE
+	volatile uint32_t edge_us;		// First raw edge since debounced state settled
+	volatile bool edge_latched;
+	uint32_t change_us;
+	uint32_t press_us;
+	uint32_t release_us;
+#ifndef BTN_TIMESTAMPS_EXTI_USE
+	enum btn_state raw_state;
+#endif
+#endif
+};
+
+
+
+// Events pending are raised ^ taken. Handler only toggles raised, callers in main loop only copy raised into taken
+struct btn_events {
+	volatile uint32_t raised[USER_IO_BITMAP_WORDS(BTNS_AMOUNT)];
+	volatile uint32_t taken[USER_IO_BITMAP_WORDS(BTNS_AMOUNT)];
+};
+#endif
+
+
+
+#ifdef BTN_LADDER_USE
+struct btn_ladder_band {
+	uint8_t channel;
+	uint16_t min;
+	uint16_t max;
+	enum btn_id id;
+};
+#endif
+
+
+
+#ifdef ENCODERS_USE
+struct encoder {
+	volatile uint32_t steps;
+	uint32_t read_steps;
+	uint32_t window_steps;
+	uint16_t window_counter;
+	int16_t velocity;
+	uint8_t state;
+	enum encoder_id id;
+};
+#endif
+
+
+
+#ifdef TASKS_USE
+struct task {
+	bool running;
+	uint32_t wait_ms;
+	uint16_t resume_point;
+	user_io_id_t wait_arg;
+	volatile enum task_wait wait;
+	volatile bool ready;
+	enum task_id id;
+};
+#endif
+
+
+
+#ifdef BINDINGS_USE
+struct binding {
+	volatile enum binding_source source;
+	uint16_t input;
+	enum led_id led_id;
+	enum binding_effect effect;
+	uint16_t arg_ms;
+};
+#endif
+
+
+
+#ifdef LED_MATRIX_USE
+struct led_matrix_pos {
+	uint8_t row;
+	uint8_t col;
+};
+#endif
+
+
+
+#ifdef USER_IO_RETAIN_USE
+struct user_io_retain_header {
+	uint32_t magic;
+	uint32_t checksum;
+	uint32_t size;
+	uint32_t version;
+};
+
+struct user_io_retain_region {
+	void *data;
+	uint32_t size;
 };
 #endif
 
@@ -85,6 +457,30 @@ struct led {
 	enum led_id id;
 	enum led_state set_state;
 	enum led_state curr_state;
+#ifdef LED_RGB_USE
+	uint8_t color[LED_RGB_BYTES_PER_PIXEL];
+#endif
+#ifdef LED_OUTPUT_TRACK_USE
+	bool output_on;
+#endif
+#ifdef LED_BUDGET_USE
+	bool lit; // Driven on, output_on is what effect wants
+	bool lit_next;
+#endif
+#ifdef LED_STATS_USE
+	uint32_t on_ticks;
+	uint32_t changes;
+#endif
+};
+#endif
+
+
+
+#ifdef LED_QUEUE_USE
+struct led_cmd {
+	uint16_t arg[2];
+	user_io_id_t id; // LED_REQ_ALL for every LED
+	uint8_t request;
 };
 #endif
 //---------------------------//
@@ -97,579 +493,5107 @@ struct led {
 // Prototypes begin
 //---------------------------//
 #ifdef BTNS_USE
+static uint32_t btn_events_pending(const struct btn_events *events, uint16_t word);
+static void btn_event_raise(struct btn_events *events, enum btn_id id);
+static bool btn_event_take(struct btn_events *events, enum btn_id id);
+static bool btn_events_next(struct btn_events *events, enum btn_id *id);
+static uint32_t btn_events_take(struct btn_events *events, uint16_t word);
 static void btns_init(void);
 static void btns_handle_states(void);
-static void btn_debounce(enum btn_id id);
+static void btns_handle_elapsed(uint32_t ticks);
+static uint32_t btn_handle_elapsed(enum btn_id id, enum btn_state state, uint32_t ticks);
+static void btn_handle_state(enum btn_id id, uint32_t ticks);
+static void btn_add_hold(enum btn_id id, uint32_t ticks);
+static enum btn_state btn_sample(enum btn_id id);
+static void btn_debounce(enum btn_id id, enum btn_state sample);
+#endif
+
+
+
+#ifdef BTN_DEBOUNCE_POLICY_USE
+static uint32_t btn_debounce_until(enum btn_id id, uint8_t sample);
+static void btn_debounce_skip(enum btn_id id, uint8_t sample, uint32_t ticks);
+#endif
+
+
+
+#ifdef BTN_LADDER_USE
+static void btns_ladder_sample(void);
+#endif
+
+
+
+#ifdef BTNS_SPARSE_USE
+static void btn_wake(enum btn_id id);
+static void btn_settle(enum btn_id id, uint8_t phase);
+#endif
+
+
+
+#ifdef BTN_TIMESTAMPS_USE
+static void btn_edge_latch(enum btn_id id, uint32_t edge_us);
+static uint32_t btn_edge_take(enum btn_id id);
+#endif
+
+
+
+#if defined(BTN_TIMESTAMPS_USE) && !defined(BTN_TIMESTAMPS_EXTI_USE)
+static void btn_sample_edge(enum btn_id id, enum btn_state sample, uint32_t sample_us);
+#endif
+
+
+
+#ifdef USER_IO_OS_USE
+static void user_io_os_notify(void);
+#endif
+
+
+
+#ifdef USER_IO_CTZ_PORTABLE
+static uint8_t user_io_ctz(uint32_t bits);
+#endif
+
+
+
+#ifdef USER_IO_RETAIN_USE
+static uint32_t user_io_retain_version(void);
+static uint32_t user_io_retain_checksum(const uint8_t *data, uint32_t size);
+static void user_io_retain_fixup(void);
+#endif
+
+
+
+#ifdef USER_IO_EXPANDER_USE
+static void expander_init(void);
+static void expander_take(void);
+static void expander_update(void);
+static void expander_kick(void);
+#endif
+
+
+
+#ifdef USER_IO_OVERRUN_USE
+static uint32_t user_io_overrun_missed(uint32_t start_us);
+static void user_io_overrun_end(uint32_t start_us, uint32_t missed);
+#endif
+
+
+
+#if defined(BTNS_USE) && defined(USER_IO_OS_USE)
+static uint32_t btns_pending_events(uint32_t mask);
+static void btns_set_waiting(uint32_t mask, bool waiting);
 #endif
 
 
 
 #ifdef LEDS_USE
 static void leds_init(void);
+static void led_request(enum led_request request, user_io_id_t id, uint16_t arg0, uint16_t arg1);
+static void led_set(enum led_request request, enum led_id id, uint16_t arg0, uint16_t arg1);
+static void leds_set_all(enum led_request request, uint16_t arg0, uint16_t arg1);
 static void leds_handle_effects(void);
+static void led_handle_effect(enum led_id id);
 static void led_handle_effect_blink_infinite(enum led_id id);
 static void led_handle_effect_blink_ms(enum led_id id);
 static void led_handle_effect_blink_n_times(enum led_id id);
 static void led_handle_effect_off(enum led_id id);
 static void led_handle_effect_pulse(enum led_id id);
 static void led_handle_effect_on(enum led_id id);
+static void led_output_on(enum led_id id);
+static void led_output_off(enum led_id id);
+static void led_output_toggle(enum led_id id);
+static void leds_handle_elapsed(uint32_t ticks);
+static uint32_t led_elapsed_blink(enum led_id id, uint32_t ticks, uint32_t max_toggles, uint32_t *toggles);
+static void led_elapsed_blink_ms(enum led_id id, uint32_t ticks);
+static void led_elapsed_blink_n_times(enum led_id id, uint32_t ticks);
+static void led_elapsed_pulse(enum led_id id, uint32_t ticks);
+static void led_handle_elapsed(enum led_id id, uint32_t ticks);
 #endif
 
 
 
-#ifdef INTERVALS_USE
-static void intervals_init(void);
-static void intervals_update(void);
+#ifdef LEDS_SPARSE_USE
+static void led_wake(enum led_id id);
+static void led_settle(enum led_id id);
 #endif
-//---------------------------//
-// Prototypes end
-//---------------------------//
 
 
 
-//---------------------------//
-// Variable begin
-//---------------------------//
-#ifdef ALTERNATIVE_IRQ_METHOD
-volatile bool user_io_handle_rdy = false;
+#ifdef LED_QUEUE_USE
+static void leds_queue_apply(void);
 #endif
 
 
 
-#ifdef BTNS_USE
-static uint32_t btns_idle_counter_ms = 0;
-static struct btn btn[BTNS_AMOUNT];
+#ifdef LED_BUDGET_USE
+static void led_budget_on(enum led_id id);
+static void led_budget_off(enum led_id id);
+static void leds_budget_slice(void);
+static void leds_budget_phase(uint16_t blink_rate_ms);
 #endif
 
 
 
-#ifdef LEDS_USE
-static struct led led[LEDS_AMOUNT];
+#ifdef LEDS_SHED_USE
+static void leds_shed_begin(void);
+static void leds_handle_shed(uint32_t ticks);
+static bool leds_shed_end(void);
+static void led_shed_sync(enum led_id id);
+#endif
+
+
+
+#ifdef LED_STATS_USE
+static void led_stats_clear(enum led_id id);
+static void led_stats_add_blink(enum led_id id, uint32_t first, uint32_t every, uint32_t toggles, uint32_t end);
+#endif
+
+
+
+#ifdef LED_WAVEFORM_USE
+static void leds_waveform_start(void);
+static void leds_handle_waveform(uint32_t ticks);
+static void leds_waveform_render(void);
+static void led_waveform_hold(void);
+static void led_waveform_release(void);
+#if defined(USER_IO_RETAIN_USE) || defined(LED_STATS_USE)
+static void led_waveform_rewind(void);
+static void led_waveform_forward(void);
+#endif
+#endif
+
+
+
+#ifdef LED_RGB_USE
+static void led_rgb_write(enum led_id id, const uint8_t *grb);
+static void leds_rgb_recolor(void);
+static void leds_rgb_flush(void);
 #endif
 
 
 
-#ifdef INTERVALS_USE
-static uint32_t interval[INTERVALS_AMOUNT] = {0};
-#endif
-//---------------------------//
-// Variable end
-//---------------------------//
+#ifdef INTERVALS_USE
+static void intervals_init(void);
+static void intervals_update(uint32_t ticks);
+#endif
+
+
+
+#ifdef INTERVALS_STAGGER_USE
+static void interval_stagger(enum interval_id id, uint32_t period);
+static bool interval_collides(enum interval_id id, enum interval_id other);
+static uint32_t intervals_gcd(uint32_t a, uint32_t b);
+static uint8_t intervals_max_due_search(void);
+static uint8_t intervals_max_due_from(uint32_t candidates, const uint32_t *collides, uint8_t best);
+#endif
+
+
+
+#ifdef ENCODERS_USE
+static void encoders_init(void);
+static void encoders_update_velocity(uint32_t ticks);
+#endif
+
+
+
+#ifdef TASKS_USE
+static void tasks_init(void);
+static void tasks_update(uint32_t ticks);
+static void task_wake(enum task_id id);
+#endif
+
+
+
+#ifdef BINDINGS_USE
+static void bindings_init(void);
+static void bindings_update(void);
+static bool binding_active(const struct binding *rule);
+static void binding_apply(const struct binding *rule, bool active);
+#endif
+//---------------------------//
+// Prototypes end
+//---------------------------//
+
+
+
+//---------------------------//
+// Variable begin
+//---------------------------//
+#ifdef ALTERNATIVE_IRQ_METHOD
+volatile bool user_io_handle_rdy = false;
+#endif
+
+
+
+#ifdef USER_IO_OS_USE
+static uint32_t user_io_os_fired = 0;
+#endif
+
+
+
+#ifdef USER_IO_OVERRUN_USE
+static uint32_t user_io_overrun_count = 0;
+static uint32_t user_io_missed_count = 0;
+static uint32_t user_io_max_us = 0;
+static uint32_t user_io_last_start_us = 0;
+static bool user_io_started = false;
+static uint32_t user_io_recover_ticks = 0;
+static volatile bool user_io_shedding = false;
+#endif
+
+
+
+#ifdef USER_IO_EXPANDER_USE
+static uint8_t expander_in[EXPANDER_PORTS]; // Inputs of last read taken by handler
+static uint8_t expander_rx[EXPANDER_PORTS]; // Read in flight, or completed until taken
+static volatile bool expander_rx_ready = false; // Handed from transfer callback to handler, no read starts while set
+static uint8_t expander_out[EXPANDER_PORTS]; // Output latches as set by drivers
+static uint8_t expander_latched[EXPANDER_PORTS]; // Output latches as last written
+static uint8_t expander_tx[EXPANDER_PORTS]; // Write in flight
+static uint8_t expander_tx_first = 0;
+static uint8_t expander_tx_amount = 0;
+static volatile uint8_t expander_state = EXPANDER_IDLE;
+static volatile bool expander_read_due = false;
+static uint32_t expander_error_count = 0;
+#endif
+
+
+
+#ifdef BTNS_USE
+static uint32_t btns_idle_counter_ms = 0;
+static struct btn btn[BTNS_AMOUNT];
+static struct btn_events btns_click;
+static struct btn_events btns_release;
+#endif
+
+
+
+#ifdef BTN_HOLD_EVENTS_USE
+static struct btn_events btns_hold[BTN_HOLD_THRESHOLDS_MAX]; // One per threshold
+#endif
+
+
+
+#ifdef BTNS_SPARSE_USE
+static uint32_t btns_active[USER_IO_BITMAP_WORDS(BTNS_AMOUNT)] = {0};
+static uint8_t btns_debounce_phase = 0; // Ticks mod debounce window, idle buttons keep their offset to it
+#endif
+
+
+
+#ifdef BTN_LADDER_USE
+static const struct btn_ladder_band btn_ladder_band[] = BTN_LADDER_BANDS;
+static bool btn_ladder_band_in[BTN_LADDER_BANDS_AMOUNT]; // Sample was within band last tick, band is widened by hysteresis
+#endif
+
+
+
+#ifdef LEDS_USE
+static struct led led[LEDS_AMOUNT];
+#endif
+
+
+
+#ifdef LED_QUEUE_USE
+static volatile struct led_cmd led_queue[LED_QUEUE_SIZE];
+static volatile uint8_t led_queue_head = 0; // Written by API calls only
+static volatile uint8_t led_queue_tail = 0; // Written by handler only
+static volatile uint32_t led_queue_drops = 0;
+#endif
+
+
+
+#ifdef LEDS_SPARSE_USE
+static volatile uint32_t leds_active[USER_IO_BITMAP_WORDS(LEDS_AMOUNT)] = {0};
+#endif
+
+
+
+#if defined(LED_STATS_USE) || defined(LED_BUDGET_UA)
+static const uint32_t led_current_ua[LEDS_AMOUNT] = LED_CURRENT_UA;
+#endif
+
+
+
+#ifdef LED_BUDGET_USE
+static uint32_t leds_budget_used = 0; // Cost of lit LEDs
+static bool leds_budget_short = false; // An LED that should be on isn't lit
+static user_io_id_t leds_budget_next = 0; // First LED to get a turn on next slice
+#endif
+
+
+
+#ifdef LEDS_SHED_USE
+static uint32_t leds_shed_tick = 0;
+static uint32_t led_shed_tick[LEDS_AMOUNT];
+static user_io_id_t leds_shed_next = 0;
+static volatile user_io_id_t led_shed_syncing = 0; // LED id + 1 being caught up from main, 0 if none
+#endif
+
+
+
+#ifdef LED_WAVEFORM_USE
+static uint32_t led_waveform_buf[LED_WAVEFORM_TICKS]; // Played out in a loop, a half is rendered once it was played out
+static uint32_t *led_waveform_word = 0;
+static uint32_t led_waveform_level = 0;
+static uint16_t led_waveform_rendered = 0; // Halves rendered since start
+static volatile uint16_t led_waveform_played = 0; // Halves played out since start, counted by led_waveform_half_done()
+static uint16_t led_waveform_seen = 0; // led_waveform_played at last tick
+static volatile uint16_t led_waveform_pos = 0; // Ticks played out of current half
+static volatile uint8_t led_waveform_holds = 0;
+#if defined(USER_IO_RETAIN_USE) || defined(LED_STATS_USE)
+static struct led led_waveform_start[2][LEDS_AMOUNT]; // LED states at start of each half
+static uint32_t led_waveform_level_start[2];
+static uint32_t led_waveform_replay = 0; // Ticks led_waveform_forward() replays after a rewind
+#endif
+#endif
+
+
+
+#ifdef LED_MATRIX_USE
+static const struct led_matrix_pos led_matrix_pos[LEDS_AMOUNT] = LED_MATRIX_MAP;
+static volatile uint32_t led_matrix_frame[LED_MATRIX_ROWS]; // Column bits of lit LEDs per row
+static uint8_t led_matrix_row[LED_MATRIX_ROWS]; // Rows with LEDs, in scan order
+static uint8_t led_matrix_rows_amount = 0;
+static volatile uint8_t led_matrix_scan_pos = 0;
+#endif
+
+
+
+#ifdef LED_RGB_USE
+static const uint8_t led_rgb_encode_lut[4] = {0x88, 0x8E, 0xE8, 0xEE};
+static uint8_t led_rgb_frame[LED_RGB_FRAME_SIZE];
+static uint8_t led_rgb_encoded[2][LED_RGB_ENCODED_SIZE]; // One is sent while the other is encoded
+static uint8_t led_rgb_back = 0;
+static bool led_rgb_dirty = false;
+static bool led_rgb_pending = false; // Back buffer is encoded and waits for the transfer before
+static volatile bool led_rgb_sending = false;
+static volatile uint8_t led_rgb_color_seq = 0; // Odd while led_color() writes a color
+static volatile bool led_rgb_recolor = false;
+#endif
+
+
+
+#ifdef INTERVALS_USE
+static volatile uint32_t intervals_ms = 0; // Shared clock, intervals only keep their start
+static uint32_t interval_start[INTERVALS_AMOUNT] = {0};
+#endif
+
+
+
+#if defined(INTERVALS_USE) && defined(USER_IO_OS_USE)
+static volatile uint32_t interval_wait_ms[INTERVALS_AMOUNT] = {0};
+static uint32_t intervals_waiting[USER_IO_BITMAP_WORDS(INTERVALS_AMOUNT)] = {0};
+#endif
+
+
+
+#ifdef INTERVALS_STAGGER_USE
+static volatile uint32_t intervals_ticks = 0;
+static uint32_t interval_period[INTERVALS_AMOUNT] = {0};
+static uint32_t interval_phase[INTERVALS_AMOUNT] = {0};
+#endif
+
+
+
+#ifdef ENCODERS_USE
+// Indexed by previous and current AB, gives -1, 0 or +1 step
+static const int8_t encoder_decode_lut[16] = {
+	0, -1, 1, 0,
+	1, 0, 0, -1,
+	-1, 0, 0, 1,
+	0, 1, -1, 0
+};
+static struct encoder encoder[ENCODERS_AMOUNT];
+#endif
+
+
+
+#ifdef TASKS_USE
+static struct task task[TASKS_AMOUNT];
+static bool (*task_fn[TASKS_AMOUNT])(enum task_id id); // Not retained, code may move between builds
+static volatile bool tasks_ready = false;
+#endif
+
+
+
+#ifdef BINDINGS_USE
+#ifdef BINDINGS_TABLE
+static struct binding binding[BINDINGS_AMOUNT] = BINDINGS_TABLE;
+#else
+static struct binding binding[BINDINGS_AMOUNT];
+#endif
+static bool binding_was_active[BINDINGS_AMOUNT];
+#endif
+
+
+
+#ifdef USER_IO_RETAIN_USE
+// State kept across sleep, saved in this order
+static const struct user_io_retain_region user_io_retain_region[] = {
+#ifdef USER_IO_OVERRUN_USE
+	{&user_io_overrun_count, sizeof(user_io_overrun_count)},
+	{&user_io_missed_count, sizeof(user_io_missed_count)},
+	{&user_io_max_us, sizeof(user_io_max_us)},
+#endif
+#ifdef USER_IO_EXPANDER_USE
+	{expander_out, sizeof(expander_out)},
+#endif
+#ifdef BTNS_USE
+	{&btns_idle_counter_ms, sizeof(btns_idle_counter_ms)},
+	{btn, sizeof(btn)},
+	{&btns_click, sizeof(btns_click)},
+	{&btns_release, sizeof(btns_release)},
+#endif
+#ifdef BTN_HOLD_EVENTS_USE
+	{btns_hold, sizeof(btns_hold)},
+#endif
+#ifdef BTNS_SPARSE_USE
+	{btns_active, sizeof(btns_active)},
+	{&btns_debounce_phase, sizeof(btns_debounce_phase)},
+#endif
+#ifdef LEDS_USE
+	{led, sizeof(led)},
+#endif
+#ifdef LED_QUEUE_USE
+	{(void *) led_queue, sizeof(led_queue)},
+	{(void *) &led_queue_head, sizeof(led_queue_head)},
+	{(void *) &led_queue_tail, sizeof(led_queue_tail)},
+#endif
+#ifdef LEDS_SPARSE_USE
+	{(void *) leds_active, sizeof(leds_active)},
+#endif
+#ifdef LED_RGB_USE
+	{led_rgb_frame, sizeof(led_rgb_frame)},
+#endif
+#ifdef LED_MATRIX_USE
+	{(void *) led_matrix_frame, sizeof(led_matrix_frame)},
+#endif
+#ifdef INTERVALS_USE
+	{(void *) &intervals_ms, sizeof(intervals_ms)},
+	{interval_start, sizeof(interval_start)},
+#endif
+#ifdef INTERVALS_STAGGER_USE
+	{(void *) &intervals_ticks, sizeof(intervals_ticks)},
+	{interval_period, sizeof(interval_period)},
+	{interval_phase, sizeof(interval_phase)},
+#endif
+#ifdef ENCODERS_USE
+	{encoder, sizeof(encoder)},
+#endif
+#ifdef TASKS_USE
+	{task, sizeof(task)},
+	{(void *) &tasks_ready, sizeof(tasks_ready)},
+#endif
+#ifdef BINDINGS_USE
+	{binding, sizeof(binding)},
+	{binding_was_active, sizeof(binding_was_active)},
+#endif
+};
+
+#define USER_IO_RETAIN_REGIONS (sizeof(user_io_retain_region) / sizeof(user_io_retain_region[0]))
+
+// Options, amounts and struct sizes of this build, each option is told apart by the line it's on
+static const uint32_t user_io_retain_config[] = {
+	USER_IO_RETAIN_FORMAT,
+	USER_IO_HANDLER_PERIOD_MS,
+#ifdef USER_IO_OVERRUN_USE
+	__LINE__,
+#endif
+#ifdef USER_IO_EXPANDER_USE
+	__LINE__, EXPANDER_PORTS,
+#endif
+#ifdef USER_IO_OS_USE
+	__LINE__,
+#endif
+#ifdef SWITCHES_USE
+	__LINE__,
+#endif
+#ifdef BTNS_USE
+	__LINE__, BTNS_AMOUNT, BTN_DEBOUNCE_TRESHOLD_MS, sizeof(struct btn), sizeof(struct btn_events),
+#endif
+#ifdef BTN_HOLD_EVENTS_USE
+	__LINE__, BTN_HOLD_THRESHOLDS_MAX,
+#endif
+#ifdef BTN_DEBOUNCE_EAGER_USE
+	__LINE__,
+#endif
+#ifdef BTN_DEBOUNCE_INTEGRATOR_USE
+	__LINE__, BTN_DEBOUNCE_PRESS_MS, BTN_DEBOUNCE_RELEASE_MS,
+#endif
+#ifdef BTN_LADDER_USE
+	__LINE__,
+#endif
+#ifdef BTN_TIMESTAMPS_USE
+	__LINE__,
+#endif
+#ifdef BTN_TIMESTAMPS_EXTI_USE
+	__LINE__,
+#endif
+#ifdef BTNS_SPARSE_USE
+	__LINE__,
+#endif
+#ifdef LEDS_USE
+	__LINE__, LEDS_AMOUNT, sizeof(struct led),
+#endif
+#ifdef LEDS_SPARSE_USE
+	__LINE__,
+#endif
+#ifdef LED_WAVEFORM_USE
+	__LINE__, LED_WAVEFORM_TICKS,
+#endif
+#ifdef LED_RGB_USE
+	__LINE__,
+#endif
+#ifdef LED_MATRIX_USE
+	__LINE__, LED_MATRIX_ROWS, LED_MATRIX_COLS,
+#endif
+#ifdef LED_MATRIX_CHARLIEPLEX
+	__LINE__,
+#endif
+#ifdef LED_QUEUE_USE
+	__LINE__, LED_QUEUE_SIZE, sizeof(struct led_cmd),
+#endif
+#ifdef LED_STATS_USE
+	__LINE__,
+#endif
+#ifdef LED_BUDGET_USE
+	__LINE__,
+#endif
+#ifdef INTERVALS_USE
+	__LINE__, INTERVALS_AMOUNT,
+#endif
+#ifdef INTERVALS_STAGGER_USE
+	__LINE__,
+#endif
+#ifdef INTERVALS_DRIFT_FREE_USE
+	__LINE__,
+#endif
+#ifdef ENCODERS_USE
+	__LINE__, ENCODERS_AMOUNT, sizeof(struct encoder),
+#endif
+#ifdef TASKS_USE
+	__LINE__, TASKS_AMOUNT, sizeof(struct task),
+#endif
+#ifdef BINDINGS_USE
+	__LINE__, BINDINGS_AMOUNT, sizeof(struct binding),
+#endif
+};
+
+#define USER_IO_RETAIN_CONFIGS (sizeof(user_io_retain_config) / sizeof(user_io_retain_config[0]))
+#endif
+//---------------------------//
+// Variable end
+//---------------------------//
+
+
+
+/**
+ * @fn void user_io_init(void)
+ * @brief Inits used mcu-periphs and framework used
+ * 
+ */
+void user_io_init(void) {
+#ifdef USER_IO_OS_USE
+	user_io_os_init();
+#endif
+
+
+
+// Pin drivers below may use expander pins
+#ifdef USER_IO_EXPANDER_USE
+	expander_init();
+#endif
+
+
+
+#ifdef SWITCHES_USE
+	switch_pins_init();
+#endif
+
+
+
+#ifdef BTNS_USE
+	btn_pins_init();
+#ifdef BTN_LADDER_USE
+	btn_ladder_adc_init();
+#endif
+	btns_init();
+#endif
+	
+
+
+#ifdef LEDS_USE
+	led_pins_init();
+	leds_init();
+#endif
+
+
+	
+#ifdef INTERVALS_USE
+	intervals_init();
+#endif
+
+
+
+#ifdef ENCODERS_USE
+	encoder_pins_init();
+	encoders_init();
+#endif
+
+
+
+#ifdef TASKS_USE
+	tasks_init();
+#endif
+
+
+
+#ifdef BINDINGS_USE
+	bindings_init();
+#endif
+}
+
+
+
+/**
+ * @fn void user_io_irq_handler(void)
+ * @brief Checks and updates states
+ * 
+ * @note Must be called with fixed interval 
+ */
+void user_io_irq_handler(void) {
+#ifdef USER_IO_OVERRUN_USE
+	uint32_t start_us = user_io_timestamp_us();
+	uint32_t missed = user_io_overrun_missed(start_us);
+	
+	// Timer ticks were lost while handler was late, catch up on them
+	if (missed) {
+		user_io_handler_elapsed(missed + 1);
+		user_io_started = true;
+		user_io_overrun_end(start_us, missed);
+		return;
+	}
+#endif
+
+
+
+#ifdef USER_IO_EXPANDER_USE
+	expander_take();
+#endif
+
+
+
+#ifdef BTNS_USE
+	btns_handle_states();
+#endif
+
+
+
+#ifdef LED_QUEUE_USE
+	leds_queue_apply();
+#endif
+
+
+
+#ifdef BINDINGS_USE
+	bindings_update();
+#endif
+
+
+
+#ifdef LED_WAVEFORM_USE
+	leds_handle_waveform(1);
+#elif defined(LEDS_SHED_USE)
+	if (user_io_shedding) {
+		leds_handle_shed(1);
+	} else {
+		leds_handle_effects();
+	}
+#elif defined(LEDS_USE)
+	leds_handle_effects();
+#endif
+
+
+
+#ifdef LED_BUDGET_USE
+	leds_budget_slice();
+#endif
+
+
+
+#if defined(LED_MATRIX_USE) && !defined(LED_MATRIX_EXTERNAL_SCAN)
+	led_matrix_scan();
+#endif
+
+
+
+#ifdef LED_RGB_USE
+	leds_rgb_flush();
+#endif
+
+
+
+#ifdef USER_IO_EXPANDER_USE
+	expander_update();
+#endif
+
+
+	
+#ifdef INTERVALS_USE
+	intervals_update(1);
+#endif
+
+
+
+#ifdef ENCODERS_USE
+#ifndef ENCODERS_EXTERNAL_SAMPLE
+	encoders_sample();
+#endif
+	encoders_update_velocity(1);
+#endif
+
+
+
+#ifdef TASKS_USE
+	tasks_update(1);
+#endif
+
+
+
+#ifdef USER_IO_OS_USE
+	user_io_os_notify();
+#endif
+
+
+
+#ifdef USER_IO_OVERRUN_USE
+	user_io_overrun_end(start_us, 0);
+#endif
+}
+
+
+
+/**
+ * @fn void user_io_handler_elapsed(uint32_t)
+ * @brief Checks and updates states as if handler was called ticks times
+ * 
+ * @param ticks (uint32_t) handler periods elapsed since last call
+ * 
+ * @note Cost doesn't depend on ticks. Inputs are sampled once,
+ * LED effects and intervals end up exactly where they would have been
+ */
+void user_io_handler_elapsed(uint32_t ticks) {
+	if (ticks <= 1) {
+		if (ticks) {
+			user_io_irq_handler();
+		}
+		return;
+	}
+	
+#ifdef USER_IO_OVERRUN_USE
+	// Gap is accounted for here, next tick must not find it again from the last timestamp
+	user_io_started = false;
+#endif
+	
+#ifdef USER_IO_EXPANDER_USE
+	expander_take();
+#endif
+	
+#ifdef BTNS_USE
+	btns_handle_elapsed(ticks);
+#endif
+
+
+
+#ifdef LED_QUEUE_USE
+	leds_queue_apply();
+#endif
+
+
+
+#ifdef LED_WAVEFORM_USE
+	leds_handle_waveform(ticks);
+#elif defined(LEDS_SHED_USE)
+	if (user_io_shedding) {
+		leds_handle_shed(ticks);
+	} else {
+		leds_handle_elapsed(ticks);
+	}
+#elif defined(LEDS_USE)
+	leds_handle_elapsed(ticks);
+#endif
+
+
+
+#ifdef LED_BUDGET_USE
+	leds_budget_slice();
+#endif
+
+
+
+// Inputs were sampled at last tick, effects start from next tick
+#ifdef BINDINGS_USE
+	bindings_update();
+#endif
+
+
+
+#if defined(LED_MATRIX_USE) && !defined(LED_MATRIX_EXTERNAL_SCAN)
+	led_matrix_scan();
+#endif
+
+
+
+#ifdef LED_RGB_USE
+	leds_rgb_flush();
+#endif
+
+
+
+#ifdef USER_IO_EXPANDER_USE
+	expander_update();
+#endif
+
+
+
+#ifdef INTERVALS_USE
+	intervals_update(ticks);
+#endif
+
+
+
+#ifdef ENCODERS_USE
+#ifndef ENCODERS_EXTERNAL_SAMPLE
+	encoders_sample();
+#endif
+	encoders_update_velocity(ticks);
+#endif
+
+
+
+#ifdef TASKS_USE
+	tasks_update(ticks);
+#endif
+
+
+
+#ifdef USER_IO_OS_USE
+	user_io_os_notify();
+#endif
+}
+
+
+
+#ifdef USER_IO_OS_USE
+/**
+ * @fn void user_io_os_notify(void)
+ * @brief Wakes tasks waiting for events that fired this tick
+ * 
+ */
+static void user_io_os_notify(void) {
+	if (user_io_os_fired) {
+		user_io_os_signal(user_io_os_fired);
+		user_io_os_fired = 0;
+	}
+}
+#endif
+
+
+
+#ifdef USER_IO_CTZ_PORTABLE
+/**
+ * @fn uint8_t user_io_ctz(uint32_t)
+ * @brief Counts trailing zero bits
+ * 
+ * @param bits (uint32_t) non zero bitmap
+ * @return (uint8_t) index of lowest set bit
+ */
+static uint8_t user_io_ctz(uint32_t bits) {
+	uint8_t count = 0;
+	
+	while (!(bits & 1U)) {
+		bits >>= 1;
+		count++;
+	}
+	return count;
+}
+#endif
+
+
+
+#ifdef USER_IO_RETAIN_USE
+/**
+ * @fn uint32_t user_io_retain_size(void)
+ * @brief Returns size of block needed by user_io_save()
+ * 
+ * @return (uint32_t) bytes
+ */
+uint32_t user_io_retain_size(void) {
+	uint32_t size = sizeof(struct user_io_retain_header);
+	
+	for (uint8_t i = 0; i < USER_IO_RETAIN_REGIONS; i++) {
+		size += user_io_retain_region[i].size;
+	}
+	return size;
+}
+
+
+
+/**
+ * @fn bool user_io_save(void*, uint32_t)
+ * @brief Saves complete state into retained block, LED effects keep their phase
+ * 
+ * @param block (void*) retained RAM, any alignment
+ * @param size (uint32_t) block size
+ * @return (bool) false if block is smaller than user_io_retain_size()
+ * 
+ * @note Call with handler stopped, right before entering sleep
+ */
+bool user_io_save(void *block, uint32_t size) {
+	struct user_io_retain_header header;
+	uint8_t *payload = (uint8_t *) block + sizeof(header);
+	uint8_t *dst = payload;
+	
+	if (size < user_io_retain_size()) {
+		return false;
+	}
+	
+	// Bring LEDs to current tick, effects rendered or shed ahead aren't saved
+#ifdef LED_WAVEFORM_USE
+	led_waveform_rewind();
+#endif
+#ifdef LEDS_SHED_USE
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		led_shed_sync(id);
+	}
+#endif
+
+	for (uint8_t i = 0; i < USER_IO_RETAIN_REGIONS; i++) {
+		memcpy(dst, user_io_retain_region[i].data, user_io_retain_region[i].size);
+		dst += user_io_retain_region[i].size;
+	}
+	
+#ifdef LED_WAVEFORM_USE
+	led_waveform_forward();
+#endif
+
+	header.magic = USER_IO_RETAIN_MAGIC;
+	header.version = user_io_retain_version();
+	header.size = (uint32_t) (dst - payload);
+	header.checksum = user_io_retain_checksum(payload, header.size);
+	memcpy(block, &header, sizeof(header));
+	
+	return true;
+}
+
+
+
+/**
+ * @fn bool user_io_resume(const void*, uint32_t)
+ * @brief Inits from state saved by user_io_save(), pins keep their configuration
+ * 
+ * @param block (const void*) retained RAM
+ * @param size (uint32_t) block size
+ * @return (bool) true if resumed, false if block was invalid and user_io_init() was done instead
+ * 
+ * @note Block is rejected after power loss or when retained layout changed between builds
+ */
+bool user_io_resume(const void *block, uint32_t size) {
+	struct user_io_retain_header header;
+	const uint8_t *src = (const uint8_t *) block + sizeof(header);
+	uint32_t payload_size = user_io_retain_size() - (uint32_t) sizeof(header);
+	
+	// Anything but an intact block of this build starts over
+	if (size < (payload_size + sizeof(header))) {
+		user_io_init();
+		return false;
+	}
+	
+	memcpy(&header, block, sizeof(header));
+	if ((header.magic != USER_IO_RETAIN_MAGIC) || (header.version != user_io_retain_version())
+			|| (header.size != payload_size) || (header.checksum != user_io_retain_checksum(src, payload_size))) {
+		user_io_init();
+		return false;
+	}
+	
+	for (uint8_t i = 0; i < USER_IO_RETAIN_REGIONS; i++) {
+		memcpy(user_io_retain_region[i].data, src, user_io_retain_region[i].size);
+		src += user_io_retain_region[i].size;
+	}
+	
+#ifdef USER_IO_OS_USE
+	user_io_os_init();
+#endif
+	user_io_pins_resume();
+	user_io_retain_fixup();
+	
+	return true;
+}
+
+
+
+/**
+ * @fn uint32_t user_io_retain_version(void)
+ * @brief FNV-1a hash of options, amounts, struct sizes and region sizes of this build
+ * 
+ * @return (uint32_t)
+ * 
+ * @note A block saved by a build with other options or layout of same total size is rejected
+ */
+static uint32_t user_io_retain_version(void) {
+	uint32_t hash = 2166136261U;
+	
+	for (uint8_t i = 0; i < USER_IO_RETAIN_CONFIGS; i++) {
+		hash = (hash ^ user_io_retain_config[i]) * 16777619U;
+	}
+	
+	for (uint8_t i = 0; i < USER_IO_RETAIN_REGIONS; i++) {
+		hash = (hash ^ user_io_retain_region[i].size) * 16777619U;
+	}
+	return hash;
+}
+
+
+
+/**
+ * @fn uint32_t user_io_retain_checksum(const uint8_t*, uint32_t)
+ * @brief FNV-1a hash of saved state
+ * 
+ * @param data (const uint8_t*) saved state
+ * @param size (uint32_t) bytes
+ * @return (uint32_t)
+ */
+static uint32_t user_io_retain_checksum(const uint8_t *data, uint32_t size) {
+	uint32_t hash = 2166136261U;
+	
+	for (uint32_t i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 16777619U;
+	}
+	return hash;
+}
+
+
+
+/**
+ * @fn void user_io_retain_fixup(void)
+ * @brief Resets state that doesn't outlive sleep and drives LEDs to their restored levels
+ * 
+ */
+static void user_io_retain_fixup(void) {
+#ifdef USER_IO_OVERRUN_USE
+	// Time spent in sleep isn't lost ticks
+	user_io_started = false;
+	user_io_shedding = false;
+	user_io_recover_ticks = 0;
+#endif
+
+#ifdef USER_IO_EXPANDER_USE
+	// Transfers didn't survive sleep, expander may have lost its latches
+	expander_state = EXPANDER_IDLE;
+	expander_read_due = false;
+	expander_rx_ready = false;
+	for (uint8_t port = 0; port < EXPANDER_PORTS; port++) {
+		expander_in[port] = EXPANDER_INPUT_IDLE;
+		expander_latched[port] = (uint8_t) ~expander_out[port];
+	}
+#endif
+
+#if defined(BTNS_USE) && defined(USER_IO_OS_USE)
+	for (user_io_id_t id = 0; id < BTNS_AMOUNT; id++) {
+		btn[id].os_waiting = false;
+	}
+#endif
+
+#ifdef LED_WAVEFORM_USE
+	// Transfer didn't survive sleep, first word of each half drives absolute levels
+	leds_waveform_start();
+#elif defined(LED_RGB_USE)
+	// Transfer didn't survive sleep
+	led_rgb_dirty = true;
+	led_rgb_pending = false;
+	led_rgb_sending = false;
+	led_rgb_recolor = false;
+#elif defined(LED_BUDGET_USE)
+	// Lit LEDs stay within budget, others get their turn on next slice
+	leds_budget_used = 0;
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		if (led[id].lit) {
+			leds_budget_used += LED_BUDGET_COST(id);
+			led_driver_on(id);
+		} else {
+			led_driver_off(id);
+		}
+	}
+	leds_budget_short = true;
+#elif defined(LEDS_USE) && !defined(LED_MATRIX_USE)
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		if (led[id].output_on) {
+			led_driver_on(id);
+		} else {
+			led_driver_off(id);
+		}
+	}
+#endif
+}
+#endif
+
+
+
+#ifdef USER_IO_OVERRUN_USE
+/**
+ * @fn uint32_t user_io_overruns(void)
+ * @brief Returns how many times handler took longer than USER_IO_OVERRUN_BUDGET_US
+ * 
+ * @return (uint32_t)
+ */
+uint32_t user_io_overruns(void) {
+	return user_io_overrun_count;
+}
+
+
+
+/**
+ * @fn uint32_t user_io_missed_ticks(void)
+ * @brief Returns how many timer ticks were lost, found from time between handler calls
+ * 
+ * @return (uint32_t)
+ * 
+ * @note Lost ticks are caught up on, effects and intervals stay on time
+ */
+uint32_t user_io_missed_ticks(void) {
+	return user_io_missed_count;
+}
+
+
+
+/**
+ * @fn uint32_t user_io_handler_max_us(void)
+ * @brief Returns longest time handler took
+ * 
+ * @return (uint32_t)
+ */
+uint32_t user_io_handler_max_us(void) {
+	return user_io_max_us;
+}
+
+
+
+/**
+ * @fn bool user_io_overloaded(void)
+ * @brief Checks if handler is shedding LED work after an overrun
+ * 
+ * @return (bool)
+ * 
+ * @note Buttons are still handled every tick, LEDs are updated USER_IO_SHED_LEDS_PER_TICK at a time
+ */
+bool user_io_overloaded(void) {
+	return user_io_shedding;
+}
+
+
+
+/**
+ * @fn uint32_t user_io_overrun_missed(uint32_t)
+ * @brief Finds ticks lost since last handler call
+ * 
+ * @param start_us (uint32_t) timestamp at start of handler
+ * @return (uint32_t) ticks lost, 0 if on time
+ */
+static uint32_t user_io_overrun_missed(uint32_t start_us) {
+	const uint32_t period_us = USER_IO_HANDLER_PERIOD_MS * 1000U;
+	uint32_t since_us = start_us - user_io_last_start_us;
+	
+	user_io_last_start_us = start_us;
+	
+	// No previous call to compare with
+	if (!user_io_started) {
+		user_io_started = true;
+		return 0;
+	}
+	
+	// Allow half a period of jitter
+	if (since_us < (period_us + (period_us / 2))) {
+		return 0;
+	}
+	
+	uint32_t missed = ((since_us + (period_us / 2)) / period_us) - 1;
+	user_io_missed_count += missed;
+	
+	return missed;
+}
+
+
+
+/**
+ * @fn void user_io_overrun_end(uint32_t, uint32_t)
+ * @brief Measures handler, enters or leaves overloaded mode
+ * 
+ * @param start_us (uint32_t) timestamp at start of handler
+ * @param missed (uint32_t) ticks lost before this call
+ */
+static void user_io_overrun_end(uint32_t start_us, uint32_t missed) {
+	uint32_t took_us = user_io_timestamp_us() - start_us;
+	
+	if (took_us > user_io_max_us) {
+		user_io_max_us = took_us;
+	}
+	
+	if (took_us > USER_IO_OVERRUN_BUDGET_US) {
+		user_io_overrun_count++;
+	}
+	
+	if ((took_us > USER_IO_OVERRUN_BUDGET_US) || missed) {
+		user_io_recover_ticks = 0;
+		
+		if (!user_io_shedding) {
+#ifdef LEDS_SHED_USE
+			leds_shed_begin();
+#endif
+			user_io_shedding = true;
+		}
+		return;
+	}
+	
+	// Leave after a while within budget
+	if (user_io_shedding && (++user_io_recover_ticks >= USER_IO_SHED_RECOVER_TICKS)) {
+#ifdef LEDS_SHED_USE
+		if (!leds_shed_end()) {
+			return;
+		}
+#endif
+		user_io_shedding = false;
+	}
+}
+#endif
+
+
+
+#ifdef SWITCHES_USE
+/**
+ * @fn bool switch_check(enum switch_id)
+ * @brief Checks if switch is on
+ * 
+ * @param id (enum switch_id)
+ * @return (bool)
+ */
+bool switch_on(enum switch_id id) {
+	return switch_get_state(id);
+}
+
+
+
+/**
+ * @fn bool switch_off(enum switch_id)
+ * @brief Checks if switch is off
+ * 
+ * @param id (enum switch_id)
+ * @return (bool)
+ */
+bool switch_off(enum switch_id id) {
+	return !switch_get_state(id);
+}
+#endif
+
+
+
+#ifdef BTNS_USE
+/**
+ * @fn bool btn_hold(enum btn_id)
+ * @brief Checks if button is held down more than threshold in milliseconds
+ * 
+ * @param id (enum btn_id)
+ * @return (bool)
+ * 
+ * @note Always check for the longest hold duration first to avoid missing longer hold events.
+ */
+bool btn_hold_ms(enum btn_id id, uint16_t ms) {
+	return (btn[id].hold_duration >= ms)? true : false;
+}
+
+
+
+/**
+ * @fn bool btn_depressed(enum btn_id)
+ * @brief Checks if button is depressed
+ * 
+ * @param id (enum btn_id)
+ * @return (bool)
+ */
+bool btn_depressed(enum btn_id id) {
+	return !btn[id].hold_duration;
+}
+
+
+
+/**
+ * @fn bool btn_released(enum btn_id)
+ * @brief Checks if button is released
+ * 
+ * @param id (enum btn_id)
+ * @return (bool)
+ */
+bool btn_released(enum btn_id id) {
+	return btn_event_take(&btns_release, id);
+}
+
+
+
+/**
+ * @fn bool btn_click(enum btn_id)
+ * @brief Checks if click is registered on specified button
+ * 
+ * @param id (enum btn_id)
+ * @return (bool)
+ */
+bool btn_click(enum btn_id id) {
+	return btn_event_take(&btns_click, id);
+}
+
+
+
+/**
+ * @fn bool btn_next_click(enum btn_id*)
+ * @brief Finds button with a click registered, lowest id first
+ * 
+ * @param id (enum btn_id*) set to button clicked
+ * @return (bool) false if no click is pending
+ * 
+ * @note Call until false to read all clicks, only buttons with a click are scanned
+ */
+bool btn_next_click(enum btn_id *id) {
+	return btn_events_next(&btns_click, id);
+}
+
+
+
+/**
+ * @fn bool btn_next_release(enum btn_id*)
+ * @brief Finds button with a release registered, lowest id first
+ * 
+ * @param id (enum btn_id*) set to button released
+ * @return (bool) false if no release is pending
+ */
+bool btn_next_release(enum btn_id *id) {
+	return btn_events_next(&btns_release, id);
+}
+
+
+
+/**
+ * @fn uint32_t btn_click_mask(uint16_t)
+ * @brief Returns and resets clicks registered on 32 buttons at once
+ * 
+ * @param word (uint16_t) group of buttons, 0 for buttons 0..31
+ * @return (uint32_t) bit n set if button word * 32 + n was clicked
+ */
+uint32_t btn_click_mask(uint16_t word) {
+	return btn_events_take(&btns_click, word);
+}
+
+
+
+/**
+ * @fn uint32_t btn_release_mask(uint16_t)
+ * @brief Returns and resets releases registered on 32 buttons at once
+ * 
+ * @param word (uint16_t) group of buttons, 0 for buttons 0..31
+ * @return (uint32_t) bit n set if button word * 32 + n was released
+ */
+uint32_t btn_release_mask(uint16_t word) {
+	return btn_events_take(&btns_release, word);
+}
+
+
+
+/**
+ * @fn bool btns_no_input_ms(uint32_t)
+ * @brief Checks for lack of input on all btns for more than idle_ms
+ * 
+ * @param idle_ms (uint32_t) no input threshold
+ * @return (bool)
+ */
+bool btns_no_input_ms(uint32_t idle_ms) {
+	if (btns_idle_counter_ms > idle_ms) {
+		return true;
+	}
+	return false;
+}
+
+
+
+#ifdef BTN_HOLD_EVENTS_USE
+/**
+ * @fn void btn_hold_thresholds_set(enum btn_id, const uint16_t*, uint8_t)
+ * @brief Registers hold thresholds for specified button, each fires once per press
+ * 
+ * @param id (enum btn_id) button to register thresholds for
+ * @param thresholds_ms (const uint16_t*) hold thresholds in ms, sorted shortest first
+ * @param n (uint8_t) amount of thresholds, capped at BTN_HOLD_THRESHOLDS_MAX
+ * 
+ * @note Pass n = 0 to remove all thresholds
+ */
+void btn_hold_thresholds_set(enum btn_id id, const uint16_t *thresholds_ms, uint8_t n) {
+	if (n > BTN_HOLD_THRESHOLDS_MAX) {
+		n = BTN_HOLD_THRESHOLDS_MAX;
+	}
+	
+	// Disable thresholds while updating
+	btn[id].hold_thresholds_amount = 0;
+	
+	for (uint8_t i = 0; i < n; i++) {
+		btn[id].hold_thresholds[i] = thresholds_ms[i];
+	}
+	
+	btn[id].hold_next = 0;
+	for (uint8_t i = 0; i < BTN_HOLD_THRESHOLDS_MAX; i++) {
+		btn_event_take(&btns_hold[i], id);
+	}
+	btn[id].hold_thresholds_amount = n;
+}
+
+
+
+/**
+ * @fn uint8_t btn_hold_event(enum btn_id)
+ * @brief Returns next hold threshold crossed on specified button
+ * 
+ * @param id (enum btn_id)
+ * @return (uint8_t) threshold number 1..n in registered order, 0 if none
+ * 
+ * @note Each threshold is reported once per press, call repeatedly if several were crossed since last check
+ */
+uint8_t btn_hold_event(enum btn_id id) {
+	for (uint8_t i = 0; i < BTN_HOLD_THRESHOLDS_MAX; i++) {
+		if (btn_event_take(&btns_hold[i], id)) {
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+
+
+/**
+ * @fn uint8_t btn_next_hold_event(enum btn_id*)
+ * @brief Finds button with a hold threshold crossed, lowest id first
+ * 
+ * @param id (enum btn_id*) set to button held
+ * @return (uint8_t) threshold number 1..n as btn_hold_event(), 0 if none
+ */
+uint8_t btn_next_hold_event(enum btn_id *id) {
+	for (uint16_t word = 0; word < USER_IO_BITMAP_WORDS(BTNS_AMOUNT); word++) {
+		uint32_t pending = 0;
+		
+		for (uint8_t i = 0; i < BTN_HOLD_THRESHOLDS_MAX; i++) {
+			pending |= btn_events_pending(&btns_hold[i], word);
+		}
+		
+		if (pending) {
+			*id = (enum btn_id) ((word << 5) + USER_IO_CTZ(pending));
+			return btn_hold_event(*id);
+		}
+	}
+	return 0;
+}
+#endif
+
+
+
+#ifdef BTN_TIMESTAMPS_USE
+/**
+ * @fn uint32_t btn_press_us(enum btn_id)
+ * @brief Returns timestamp of raw edge that started last registered press
+ * 
+ * @param id (enum btn_id)
+ * @return (uint32_t) user_io_timestamp_us() value, valid after btn_click()
+ * 
+ * @note Timestamps wrap around, use differences only
+ */
+uint32_t btn_press_us(enum btn_id id) {
+	return btn[id].press_us;
+}
+
+
+
+/**
+ * @fn uint32_t btn_release_us(enum btn_id)
+ * @brief Returns timestamp of raw edge that started last registered release
+ * 
+ * @param id (enum btn_id)
+ * @return (uint32_t) user_io_timestamp_us() value, valid after btn_released()
+ * 
+ * @note Timestamps wrap around, use differences only
+ */
+uint32_t btn_release_us(enum btn_id id) {
+	return btn[id].release_us;
+}
+#endif
+
+
+
+#ifdef BTN_TIMESTAMPS_EXTI_USE
+/**
+ * @fn void btn_edge_irq(enum btn_id)
+ * @brief Timestamps raw edge on specific button, call from EXTI callback on both edges
+ * 
+ * @param id (enum btn_id)
+ * 
+ * @note Pin isn't read, only the first edge after the debounced state settled is kept and
+ * it starts the next change either way. Buttons on resistor ladders are not supported
+ */
+void btn_edge_irq(enum btn_id id) {
+	btn_edge_latch(id, user_io_timestamp_us());
+}
+#endif
+
+
+
+#ifdef USER_IO_OS_USE
+/**
+ * @fn uint32_t btn_wait_event(uint32_t, uint32_t)
+ * @brief Blocks calling task until a click, release or hold threshold is registered on any button in mask
+ * 
+ * @param mask (uint32_t) buttons to wait for, bit n is button n
+ * @param timeout_ms (uint32_t) max time to block, USER_IO_WAIT_FOREVER to not time out
+ * @return (uint32_t) buttons with events pending, 0 if timed out
+ * 
+ * @note Events are not consumed, read them with btn_click(), btn_released() etc.
+ * One task may wait for a button at a time
+ */
+uint32_t btn_wait_event(uint32_t mask, uint32_t timeout_ms) {
+	uint32_t events = btns_pending_events(mask);
+	
+	if (events) {
+		return events;
+	}
+	
+	// Register before checking again, handler signals anything after this
+	user_io_os_clear(mask);
+	btns_set_waiting(mask, true);
+	
+	events = btns_pending_events(mask);
+	if (!events) {
+		user_io_os_wait(mask, timeout_ms);
+		events = btns_pending_events(mask);
+	}
+	
+	btns_set_waiting(mask, false);
+	
+	return events;
+}
+
+
+
+/**
+ * @fn uint32_t btns_pending_events(uint32_t)
+ * @brief Returns buttons in mask with unread events
+ * 
+ * @param mask (uint32_t) buttons to check, bit n is button n
+ * @return (uint32_t)
+ */
+static uint32_t btns_pending_events(uint32_t mask) {
+	// Up to 32 buttons, bit n of first word is button n
+	uint32_t events = btn_events_pending(&btns_click, 0) | btn_events_pending(&btns_release, 0);
+	
+#ifdef BTN_HOLD_EVENTS_USE
+	for (uint8_t i = 0; i < BTN_HOLD_THRESHOLDS_MAX; i++) {
+		events |= btn_events_pending(&btns_hold[i], 0);
+	}
+#endif
+	return events & mask;
+}
+
+
+
+/**
+ * @fn void btns_set_waiting(uint32_t, bool)
+ * @brief Marks buttons in mask as waited for, handler only signals those
+ * 
+ * @param mask (uint32_t) buttons, bit n is button n
+ * @param waiting (bool)
+ */
+static void btns_set_waiting(uint32_t mask, bool waiting) {
+	for (user_io_id_t id = 0; id < BTNS_AMOUNT; id++) {
+		if (mask & USER_IO_OS_BTN_BIT(id)) {
+			btn[id].os_waiting = waiting;
+		}
+	}
+}
+#endif
+
+
+
+/**
+ * @fn void btns_init(void)
+ * @brief Inits all buttons with default params
+ * 
+ */
+static void btns_init(void) {
+	for (user_io_id_t id = 0; id < BTNS_AMOUNT; id++) {
+		btn[id].id = id;
+		btn[id].curr_state = BTN_DEPRESSED;
+		btn[id].last_state = BTN_DEPRESSED;
+		btn[id].debounce_counter = 0;
+		btn[id].press_counter = 0;
+		btn[id].hold_duration = 0;
+#ifdef BTN_HOLD_EVENTS_USE
+		btn[id].hold_thresholds_amount = 0;
+		btn[id].hold_next = 0;
+#endif
+#ifdef BTN_LADDER_USE
+		btn[id].on_ladder = false;
+		btn[id].ladder_state = BTN_DEPRESSED;
+#endif
+#ifdef BTN_TIMESTAMPS_USE
+		btn[id].edge_us = 0;
+		btn[id].edge_latched = false;
+		btn[id].change_us = user_io_timestamp_us() - BTN_EDGE_SETTLE_US;
+		btn[id].press_us = 0;
+		btn[id].release_us = 0;
+#ifndef BTN_TIMESTAMPS_EXTI_USE
+		btn[id].raw_state = BTN_DEPRESSED;
+#endif
+#endif
+#ifdef USER_IO_OS_USE
+		btn[id].os_waiting = false;
+#endif
+	}
+
+#ifdef BTN_LADDER_USE
+	for (uint8_t band = 0; band < BTN_LADDER_BANDS_AMOUNT; band++) {
+		btn[btn_ladder_band[band].id].on_ladder = true;
+		btn_ladder_band_in[band] = false;
+	}
+#endif
+
+	for (uint16_t word = 0; word < USER_IO_BITMAP_WORDS(BTNS_AMOUNT); word++) {
+		btns_click.raised[word] = 0;
+		btns_click.taken[word] = 0;
+		btns_release.raised[word] = 0;
+		btns_release.taken[word] = 0;
+#ifdef BTN_HOLD_EVENTS_USE
+		for (uint8_t i = 0; i < BTN_HOLD_THRESHOLDS_MAX; i++) {
+			btns_hold[i].raised[word] = 0;
+			btns_hold[i].taken[word] = 0;
+		}
+#endif
+	}
+
+#ifdef BTNS_SPARSE_USE
+	// All idle, in phase with each other
+	for (uint16_t word = 0; word < USER_IO_BITMAP_WORDS(BTNS_AMOUNT); word++) {
+		btns_active[word] = 0;
+	}
+	btns_debounce_phase = 0;
+#endif
+}
+
+
+
+/**
+ * @fn void btns_handle_states(void)
+ * @brief Update btn states, check for click or hold etc
+ * 
+ */
+static void btns_handle_states(void) {
+#if defined(BTN_TIMESTAMPS_USE) && !defined(BTN_TIMESTAMPS_EXTI_USE)
+	uint32_t sample_us = user_io_timestamp_us();
+#endif
+
+	if (btns_idle_counter_ms < BTNS_IDLE_MS_MAX) {
+		btns_idle_counter_ms += USER_IO_HANDLER_PERIOD_MS;
+	}
+
+#ifdef BTN_LADDER_USE
+	btns_ladder_sample();
+#endif
+	
+#ifdef BTNS_SPARSE_USE
+	uint8_t phase = (uint8_t) ((btns_debounce_phase + 1U) % (BTN_DEBOUNCE_TRESHOLD + 1U));
+	
+	// Only buttons pressed now or not yet settled
+	for (uint16_t word = 0; word < USER_IO_BITMAP_WORDS(BTNS_AMOUNT); word++) {
+		uint32_t walk = btns_active[word] | btns_get_pressed(word);
+		
+		while (walk) {
+			user_io_id_t id = (user_io_id_t) ((word << 5) + USER_IO_CTZ(walk));
+			
+			walk &= walk - 1;
+			if (id >= BTNS_AMOUNT) {
+				break;
+			}
+			
+			enum btn_state sample = btn_sample(id);
+			
+			btn_wake(id);
+#if defined(BTN_TIMESTAMPS_USE) && !defined(BTN_TIMESTAMPS_EXTI_USE)
+			btn_sample_edge(id, sample, sample_us);
+#endif
+			btn_debounce(id, sample);
+			btn_handle_state(id, 1);
+			btn_settle(id, phase);
+		}
+	}
+	btns_debounce_phase = phase;
+#else
+	for (user_io_id_t id = 0; id < BTNS_AMOUNT; id++) {
+		enum btn_state sample = btn_sample(id);
+		
+#if defined(BTN_TIMESTAMPS_USE) && !defined(BTN_TIMESTAMPS_EXTI_USE)
+		btn_sample_edge(id, sample, sample_us);
+#endif
+		btn_debounce(id, sample);
+		btn_handle_state(id, 1);
+	}
+#endif
+}
+
+
+
+/**
+ * @fn void btns_handle_elapsed(uint32_t)
+ * @brief Update btn states as if handler was called ticks times
+ * 
+ * @param ticks (uint32_t) ticks elapsed
+ * 
+ * @note Buttons are sampled once, the sample is used for all elapsed ticks
+ */
+static void btns_handle_elapsed(uint32_t ticks) {
+	uint32_t idle_ticks = ticks;
+	uint32_t idle_counter_ms = btns_idle_counter_ms;
+#if defined(BTN_TIMESTAMPS_USE) && !defined(BTN_TIMESTAMPS_EXTI_USE)
+	uint32_t sample_us = user_io_timestamp_us();
+#endif
+
+#ifdef BTN_LADDER_USE
+	btns_ladder_sample();
+#endif
+	
+#ifdef BTNS_SPARSE_USE
+	uint8_t phase = (uint8_t) ((btns_debounce_phase + ticks) % (BTN_DEBOUNCE_TRESHOLD + 1U));
+	
+	for (uint16_t word = 0; word < USER_IO_BITMAP_WORDS(BTNS_AMOUNT); word++) {
+		uint32_t walk = btns_active[word] | btns_get_pressed(word);
+		
+		while (walk) {
+			user_io_id_t id = (user_io_id_t) ((word << 5) + USER_IO_CTZ(walk));
+			
+			walk &= walk - 1;
+			if (id >= BTNS_AMOUNT) {
+				break;
+			}
+			
+			enum btn_state sample = btn_sample(id);
+			
+			btn_wake(id);
+#if defined(BTN_TIMESTAMPS_USE) && !defined(BTN_TIMESTAMPS_EXTI_USE)
+			btn_sample_edge(id, sample, sample_us);
+#endif
+			uint32_t since_pressed = btn_handle_elapsed(id, sample, ticks);
+			
+			if (since_pressed < idle_ticks) {
+				idle_ticks = since_pressed;
+			}
+			btn_settle(id, phase);
+		}
+	}
+	btns_debounce_phase = phase;
+#else
+	for (user_io_id_t id = 0; id < BTNS_AMOUNT; id++) {
+		enum btn_state sample = btn_sample(id);
+		
+#if defined(BTN_TIMESTAMPS_USE) && !defined(BTN_TIMESTAMPS_EXTI_USE)
+		btn_sample_edge(id, sample, sample_us);
+#endif
+		uint32_t since_pressed = btn_handle_elapsed(id, sample, ticks);
+		
+		if (since_pressed < idle_ticks) {
+			idle_ticks = since_pressed;
+		}
+	}
+#endif
+	
+	// Idle time restarts after last tick any button was pressed
+	if (idle_ticks < ticks) {
+		idle_counter_ms = 0;
+	}
+	
+	// Counts up until max is reached, like once per tick
+	if (idle_counter_ms < BTNS_IDLE_MS_MAX) {
+		uint32_t until_max = ((BTNS_IDLE_MS_MAX - idle_counter_ms) + USER_IO_HANDLER_PERIOD_MS - 1) / USER_IO_HANDLER_PERIOD_MS;
+		
+		idle_counter_ms += ((idle_ticks < until_max)? idle_ticks : until_max) * USER_IO_HANDLER_PERIOD_MS;
+	}
+	btns_idle_counter_ms = idle_counter_ms;
+}
+
+
+
+/**
+ * @fn uint32_t btn_handle_elapsed(enum btn_id, enum btn_state, uint32_t)
+ * @brief Debounces and updates specific button as if handler was called ticks times
+ * 
+ * @param id (enum btn_id) button to update
+ * @param state (enum btn_state) sample held for all ticks
+ * @param ticks (uint32_t) ticks elapsed
+ * @return (uint32_t) ticks elapsed after button was last pressed, ticks if it wasn't
+ * 
+ * @note At most two debounce evaluations can change state, remaining ticks are skipped in one step
+ */
+static uint32_t btn_handle_elapsed(enum btn_id id, enum btn_state state, uint32_t ticks) {
+	uint8_t sample = (uint8_t) state;
+	uint32_t since_pressed = ticks;
+	
+#ifdef BTN_DEBOUNCE_POLICY_USE
+	uint32_t until_change = btn_debounce_until(id, sample);
+	
+	// Held sample changes state at most once, debounce that tick alone
+	if (until_change && (until_change <= ticks)) {
+		if (until_change > 1) {
+			btn_debounce_skip(id, sample, until_change - 1);
+			btn_handle_state(id, until_change - 1);
+			
+			if (btn[id].curr_state == BTN_PRESSED) {
+				since_pressed = ticks - (until_change - 1);
+			}
+		}
+		btn_debounce(id, state);
+		btn_handle_state(id, 1);
+		ticks -= until_change;
+		
+		if (btn[id].curr_state == BTN_PRESSED) {
+			since_pressed = ticks;
+		}
+	}
+	
+	if (ticks) {
+		btn_debounce_skip(id, sample, ticks);
+		btn_handle_state(id, ticks);
+		
+		if (btn[id].curr_state == BTN_PRESSED) {
+			since_pressed = 0;
+		}
+	}
+#else
+	while (ticks) {
+		uint32_t until_debounce = (uint32_t) (BTN_DEBOUNCE_TRESHOLD - btn[id].debounce_counter) + 1;
+		
+		// Not enough ticks to debounce, state unchanged
+		if (ticks < until_debounce) {
+			btn[id].debounce_counter += (uint8_t) ticks;
+			if (sample) {
+				btn[id].press_counter = (btn[id].press_counter + ticks > 0xFF)? 0xFF : (uint8_t) (btn[id].press_counter + ticks);
+			}
+			btn_handle_state(id, ticks);
+			
+			if (btn[id].curr_state == BTN_PRESSED) {
+				since_pressed = 0;
+			}
+			break;
+		}
+		
+		// Ticks up to debounce keep state, then debounce once
+		if (until_debounce > 1) {
+			btn_handle_state(id, until_debounce - 1);
+			
+			if (btn[id].curr_state == BTN_PRESSED) {
+				since_pressed = ticks - (until_debounce - 1);
+			}
+		}
+		btn[id].debounce_counter = BTN_DEBOUNCE_TRESHOLD;
+		if (sample) {
+			btn[id].press_counter = (btn[id].press_counter + until_debounce - 1 > 0xFF)? 0xFF : (uint8_t) (btn[id].press_counter + until_debounce - 1);
+		}
+		btn_debounce(id, state);
+		btn_handle_state(id, 1);
+		ticks -= until_debounce;
+		
+		if (btn[id].curr_state == BTN_PRESSED) {
+			since_pressed = ticks;
+		}
+		
+		// Debounced state matches sample, later debounces can't change it
+		if (btn[id].curr_state == (enum btn_state) sample) {
+			uint32_t partial = ticks % (BTN_DEBOUNCE_TRESHOLD + 1U);
+			
+			btn[id].debounce_counter = (uint8_t) partial;
+			btn[id].press_counter = sample? (uint8_t) partial : 0;
+			if (ticks) {
+				btn_handle_state(id, ticks);
+				
+				if (btn[id].curr_state == BTN_PRESSED) {
+					since_pressed = 0;
+				}
+			}
+			break;
+		}
+	}
+#endif
+	
+	return since_pressed;
+}
+
+
+
+/**
+ * @fn void btn_handle_state(enum btn_id, uint32_t)
+ * @brief Checks for click, hold or release on specific button after debounce
+ * 
+ * @param id (enum btn_id) button to update
+ * @param ticks (uint32_t) ticks debounced state lasted, first tick may change state
+ */
+static void btn_handle_state(enum btn_id id, uint32_t ticks) {
+	// Check for click
+	if ((btn[id].curr_state == BTN_PRESSED) && (btn[id].last_state == BTN_DEPRESSED)) {
+		btn_event_raise(&btns_click, id);
+		btns_idle_counter_ms = 0;
+#ifdef BTN_TIMESTAMPS_USE
+		btn[id].press_us = btn_edge_take(id);
+#endif
+#ifdef USER_IO_OS_USE
+		if (btn[id].os_waiting) {
+			user_io_os_fired |= USER_IO_OS_BTN_BIT(id);
+		}
+#endif
+
+		// Held for remaining ticks
+		if (ticks > 1) {
+			btn_add_hold(id, ticks - 1);
+		}
+		
+	// Check for hold 
+	} else if ((btn[id].curr_state == BTN_PRESSED) && (btn[id].last_state == BTN_PRESSED)) {
+		btn_add_hold(id, ticks);
+		btns_idle_counter_ms = 0;
+		
+	// Check for release
+	} else if ((btn[id].curr_state == BTN_DEPRESSED) && (btn[id].last_state == BTN_PRESSED)) {
+		btn_event_raise(&btns_release, id);
+		btn[id].hold_duration = 0;
+#ifdef BTN_TIMESTAMPS_USE
+		btn[id].release_us = btn_edge_take(id);
+#endif
+#ifdef BTN_HOLD_EVENTS_USE
+		btn[id].hold_next = 0;
+#endif
+#ifdef USER_IO_OS_USE
+		if (btn[id].os_waiting) {
+			user_io_os_fired |= USER_IO_OS_BTN_BIT(id);
+		}
+#endif
+	}
+	
+
+	btn[id].last_state = btn[id].curr_state;
+}
+
+
+
+/**
+ * @fn void btn_add_hold(enum btn_id, uint32_t)
+ * @brief Adds held ticks to hold duration of specific button
+ * 
+ * @param id (enum btn_id) button held
+ * @param ticks (uint32_t) ticks held
+ */
+static void btn_add_hold(enum btn_id id, uint32_t ticks) {
+	uint32_t hold = btn[id].hold_duration + (ticks * USER_IO_HANDLER_PERIOD_MS);
+	
+	btn[id].hold_duration = (hold > 0xFFFFU)? 0xFFFFU : (uint16_t) hold;
+
+#ifdef BTN_HOLD_EVENTS_USE
+	// Only the next pending threshold is compared
+	while ((btn[id].hold_next < btn[id].hold_thresholds_amount) && (btn[id].hold_duration >= btn[id].hold_thresholds[btn[id].hold_next])) {
+		btn_event_raise(&btns_hold[btn[id].hold_next], id);
+		btn[id].hold_next++;
+#ifdef USER_IO_OS_USE
+		if (btn[id].os_waiting) {
+			user_io_os_fired |= USER_IO_OS_BTN_BIT(id);
+		}
+#endif
+	}
+#endif
+}
+
+
+
+/**
+ * @fn uint32_t btn_events_pending(const struct btn_events*, uint16_t)
+ * @brief Returns events not yet read on 32 buttons
+ * 
+ * @param events (const struct btn_events*) click, release or hold bitmaps
+ * @param word (uint16_t) group of buttons
+ * @return (uint32_t) bit n set if button word * 32 + n has an event
+ */
+static uint32_t btn_events_pending(const struct btn_events *events, uint16_t word) {
+	return events->raised[word] ^ events->taken[word];
+}
+
+
+
+/**
+ * @fn void btn_event_raise(struct btn_events*, enum btn_id)
+ * @brief Registers event on specific button from handler, an unread event stays as is
+ * 
+ * @param events (struct btn_events*) click, release or hold bitmaps
+ * @param id (enum btn_id) button
+ */
+static void btn_event_raise(struct btn_events *events, enum btn_id id) {
+	if (!(btn_events_pending(events, USER_IO_BIT_WORD(id)) & USER_IO_BIT_MASK(id))) {
+		events->raised[USER_IO_BIT_WORD(id)] ^= USER_IO_BIT_MASK(id);
+	}
+}
+
+
+
+/**
+ * @fn bool btn_event_take(struct btn_events*, enum btn_id)
+ * @brief Reads and resets event on specific button, outside of handler
+ * 
+ * @param events (struct btn_events*) click, release or hold bitmaps
+ * @param id (enum btn_id) button
+ * @return (bool) true if event was pending
+ */
+static bool btn_event_take(struct btn_events *events, enum btn_id id) {
+	uint16_t word = USER_IO_BIT_WORD(id);
+	uint32_t mask = USER_IO_BIT_MASK(id);
+	uint32_t raised = events->raised[word];
+	
+	if (!((raised ^ events->taken[word]) & mask)) {
+		return false;
+	}
+	
+	// Copied, not toggled, taking it twice can't bring it back
+	events->taken[word] = (events->taken[word] & ~mask) | (raised & mask);
+	
+	return true;
+}
+
+
+
+/**
+ * @fn bool btn_events_next(struct btn_events*, enum btn_id*)
+ * @brief Reads and resets event on lowest button that has one, outside of handler
+ * 
+ * @param events (struct btn_events*) click or release bitmaps
+ * @param id (enum btn_id*) set to button
+ * @return (bool) false if no event is pending
+ */
+static bool btn_events_next(struct btn_events *events, enum btn_id *id) {
+	for (uint16_t word = 0; word < USER_IO_BITMAP_WORDS(BTNS_AMOUNT); word++) {
+		uint32_t pending = btn_events_pending(events, word);
+		
+		if (pending) {
+			uint8_t bit = USER_IO_CTZ(pending);
+			uint32_t mask = (uint32_t) 1U << bit;
+			
+			events->taken[word] = (events->taken[word] & ~mask) | (events->raised[word] & mask);
+			*id = (enum btn_id) ((word << 5) + bit);
+			
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+/**
+ * @fn uint32_t btn_events_take(struct btn_events*, uint16_t)
+ * @brief Reads and resets events on 32 buttons, outside of handler
+ * 
+ * @param events (struct btn_events*) click or release bitmaps
+ * @param word (uint16_t) group of buttons
+ * @return (uint32_t) bit n set if button word * 32 + n had an event
+ */
+static uint32_t btn_events_take(struct btn_events *events, uint16_t word) {
+	uint32_t raised = events->raised[word];
+	uint32_t pending = raised ^ events->taken[word];
+	
+	events->taken[word] = raised;
+	
+	return pending;
+}
+
+
+
+/**
+ * @fn enum btn_state btn_sample(enum btn_id)
+ * @brief Returns raw state of specific button
+ * 
+ * @param id (enum btn_id) button to read from
+ * @return (enum btn_state)
+ */
+static enum btn_state btn_sample(enum btn_id id) {
+#ifdef BTN_LADDER_USE
+	return btn[id].on_ladder? btn[id].ladder_state : btn_get_state(id);
+#else
+	return btn_get_state(id);
+#endif
+}
+
+
+
+#ifdef BTN_TIMESTAMPS_USE
+/**
+ * @fn void btn_edge_latch(enum btn_id, uint32_t)
+ * @brief Keeps raw edge if it is the first since debounced state settled
+ * 
+ * @param id (enum btn_id) button with edge
+ * @param edge_us (uint32_t) timestamp of edge
+ * 
+ * @note Edges within BTN_EDGE_SETTLE_MS of last debounced change are its bounces. A latched edge
+ * older than BTN_EDGE_WINDOW_MS never changed state, a glitch, and is replaced by the next edge
+ */
+static void btn_edge_latch(enum btn_id id, uint32_t edge_us) {
+	if ((edge_us - btn[id].change_us) < BTN_EDGE_SETTLE_US) {
+		return;
+	}
+	if (btn[id].edge_latched && ((edge_us - btn[id].edge_us) <= BTN_EDGE_WINDOW_US)) {
+		return;
+	}
+	btn[id].edge_us = edge_us;
+	btn[id].edge_latched = true;
+}
+
+
+
+/**
+ * @fn uint32_t btn_edge_take(enum btn_id)
+ * @brief Returns timestamp of edge that started debounced change now registered, re-arms latch
+ * 
+ * @param id (enum btn_id) button that changed
+ * @return (uint32_t) latched edge, time of change if none was latched within window
+ */
+static uint32_t btn_edge_take(enum btn_id id) {
+	uint32_t now_us = user_io_timestamp_us();
+	uint32_t edge_us = btn[id].edge_us;
+	bool latched = btn[id].edge_latched && ((now_us - edge_us) <= BTN_EDGE_WINDOW_US);
+	
+	btn[id].edge_latched = false;
+	btn[id].change_us = now_us;
+	
+	return latched? edge_us : now_us;
+}
+#endif
+
+
+
+#if defined(BTN_TIMESTAMPS_USE) && !defined(BTN_TIMESTAMPS_EXTI_USE)
+/**
+ * @fn void btn_sample_edge(enum btn_id, enum btn_state, uint32_t)
+ * @brief Timestamps raw edge on specific button if sample changed since last tick
+ * 
+ * @param id (enum btn_id) button sampled
+ * @param sample (enum btn_state) sample of this tick
+ * @param sample_us (uint32_t) timestamp of port read
+ */
+static void btn_sample_edge(enum btn_id id, enum btn_state sample, uint32_t sample_us) {
+	if (sample != btn[id].raw_state) {
+		btn[id].raw_state = sample;
+		btn_edge_latch(id, sample_us);
+	}
+}
+#endif
+
+
+
+/**
+ * @fn void btn_debounce(enum btn_id, enum btn_state)
+ * @brief Debounces specific button
+ * 
+ * @param id (enum btn_id) button to debounce
+ * @param sample (enum btn_state) sample of this tick
+ */
+static void btn_debounce(enum btn_id id, enum btn_state sample) {
+#if defined(BTN_DEBOUNCE_EAGER_USE)
+	// Register press on first pressed sample, released samples only count while pressed
+	if (sample == BTN_PRESSED) {
+		btn[id].curr_state = BTN_PRESSED;
+		btn[id].debounce_counter = 0;
+		
+	// Register release after full window of released samples
+	} else if (btn[id].curr_state == BTN_PRESSED) {
+		btn[id].debounce_counter++;
+		
+		if (btn[id].debounce_counter >= BTN_DEBOUNCE_TRESHOLD) {
+			btn[id].curr_state = BTN_DEPRESSED;
+			btn[id].debounce_counter = 0;
+		}
+	}
+#elif defined(BTN_DEBOUNCE_INTEGRATOR_USE)
+	// Integrate up to press threshold, leak down on released samples
+	if (btn[id].curr_state == BTN_DEPRESSED) {
+		if (sample == BTN_PRESSED) {
+			btn[id].debounce_counter++;
+			
+			if (btn[id].debounce_counter >= BTN_DEBOUNCE_PRESS) {
+				btn[id].curr_state = BTN_PRESSED;
+				btn[id].debounce_counter = BTN_DEBOUNCE_RELEASE;
+			}
+		} else if (btn[id].debounce_counter > 0) {
+			btn[id].debounce_counter--;
+		}
+		
+	// Integrate down to release, refill up to release threshold on pressed samples
+	} else {
+		if (sample == BTN_DEPRESSED) {
+			btn[id].debounce_counter--;
+			
+			if (btn[id].debounce_counter == 0) {
+				btn[id].curr_state = BTN_DEPRESSED;
+			}
+		} else if (btn[id].debounce_counter < BTN_DEBOUNCE_RELEASE) {
+			btn[id].debounce_counter++;
+		}
+	}
+#else
+	btn[id].press_counter += (uint8_t) sample;
+			
+	// Debounce btn
+	if (btn[id].debounce_counter >= BTN_DEBOUNCE_TRESHOLD) {
+		
+		// Register as press
+		if (btn[id].press_counter > 0) {
+			btn[id].curr_state = BTN_PRESSED;
+			btn[id].press_counter = 0;
+			
+		// Register as depressed, reset state
+		} else {
+			btn[id].curr_state = BTN_DEPRESSED;
+		}
+		
+		btn[id].debounce_counter = 0;
+	} else {
+		btn[id].debounce_counter++;
+	}
+#endif
+}
+
+
+
+#ifdef BTN_DEBOUNCE_POLICY_USE
+/**
+ * @fn uint32_t btn_debounce_until(enum btn_id, uint8_t)
+ * @brief Calculates ticks until debounced state changes if sample holds
+ * 
+ * @param id (enum btn_id) button to check
+ * @param sample (uint8_t) held sample
+ * @return (uint32_t) ticks until change, 0 if state doesn't change
+ */
+static uint32_t btn_debounce_until(enum btn_id id, uint8_t sample) {
+	if (btn[id].curr_state == (enum btn_state) sample) {
+		return 0;
+	}
+	
+#ifdef BTN_DEBOUNCE_EAGER_USE
+	if (sample) {
+		return 1;
+	}
+	
+	return (btn[id].debounce_counter < BTN_DEBOUNCE_TRESHOLD)? (uint32_t) (BTN_DEBOUNCE_TRESHOLD - btn[id].debounce_counter) : 1U;
+#else
+	if (sample) {
+		return BTN_DEBOUNCE_PRESS - btn[id].debounce_counter;
+	}
+	
+	return btn[id].debounce_counter;
+#endif
+}
+
+
+
+/**
+ * @fn void btn_debounce_skip(enum btn_id, uint8_t, uint32_t)
+ * @brief Advances debounce counter as if sample was debounced ticks times
+ * 
+ * @param id (enum btn_id) button to advance
+ * @param sample (uint8_t) held sample
+ * @param ticks (uint32_t) ticks to skip, must be less than btn_debounce_until()
+ */
+static void btn_debounce_skip(enum btn_id id, uint8_t sample, uint32_t ticks) {
+	uint32_t counter = btn[id].debounce_counter;
+	
+#ifdef BTN_DEBOUNCE_EAGER_USE
+	if (sample) {
+		counter = 0;
+	} else if (btn[id].curr_state == BTN_PRESSED) {
+		counter += ticks;
+	}
+#else
+	if (btn[id].curr_state == (enum btn_state) sample) {
+		counter = sample? ((counter + ticks > BTN_DEBOUNCE_RELEASE)? BTN_DEBOUNCE_RELEASE : counter + ticks) : ((counter > ticks)? counter - ticks : 0);
+	} else {
+		counter = sample? counter + ticks : counter - ticks;
+	}
+#endif
+	
+	btn[id].debounce_counter = (uint8_t) counter;
+}
+#endif
+
+
+
+#ifdef BTN_LADDER_USE
+/**
+ * @fn void btns_ladder_sample(void)
+ * @brief Reads all ladder channels once and maps voltage bands to button states
+ * 
+ * @note A band is entered within min to max and left outside of it widened by BTN_LADDER_HYSTERESIS,
+ * so noise on a voltage close to a band edge doesn't toggle the button
+ */
+static void btns_ladder_sample(void) {
+	uint16_t samples[BTN_LADDER_CHANNELS];
+	
+	btn_ladder_get_samples(samples);
+	
+	for (uint8_t band = 0; band < BTN_LADDER_BANDS_AMOUNT; band++) {
+		btn[btn_ladder_band[band].id].ladder_state = BTN_DEPRESSED;
+	}
+	
+	for (uint8_t band = 0; band < BTN_LADDER_BANDS_AMOUNT; band++) {
+		uint32_t sample = samples[btn_ladder_band[band].channel];
+		uint32_t margin = btn_ladder_band_in[band]? BTN_LADDER_HYSTERESIS : 0;
+		
+		btn_ladder_band_in[band] = ((sample + margin) >= btn_ladder_band[band].min) && (sample <= (btn_ladder_band[band].max + margin));
+		
+		if (btn_ladder_band_in[band]) {
+			btn[btn_ladder_band[band].id].ladder_state = BTN_PRESSED;
+#ifdef BTNS_SPARSE_USE
+			btn_wake(btn_ladder_band[band].id);
+#endif
+		}
+	}
+}
+#endif
+
+
+
+#ifdef BTNS_SPARSE_USE
+/**
+ * @fn void btn_wake(enum btn_id)
+ * @brief Marks specific button as active, restores its debounce window position if it was idle
+ * 
+ * @param id (enum btn_id) button to wake
+ */
+static void btn_wake(enum btn_id id) {
+	uint32_t mask = USER_IO_BIT_MASK(id);
+	
+	if (btns_active[USER_IO_BIT_WORD(id)] & mask) {
+		return;
+	}
+	btns_active[USER_IO_BIT_WORD(id)] |= mask;
+	
+#ifndef BTN_DEBOUNCE_POLICY_USE
+	// Window kept running while idle, as if sampled every tick
+	btn[id].debounce_counter = (uint8_t) ((btn[id].debounce_counter + btns_debounce_phase) % (BTN_DEBOUNCE_TRESHOLD + 1U));
+#endif
+}
+
+
+
+/**
+ * @fn void btn_settle(enum btn_id, uint8_t)
+ * @brief Marks specific button as idle once released and debounced, it's skipped until pressed again
+ * 
+ * @param id (enum btn_id) button to check
+ * @param phase (uint8_t) debounce phase after this update
+ * 
+ * @note Idle buttons only change on a pressed sample, skipping them leaves state as updating would
+ */
+static void btn_settle(enum btn_id id, uint8_t phase) {
+	if ((btn[id].curr_state != BTN_DEPRESSED) || (btn[id].last_state != BTN_DEPRESSED)) {
+		return;
+	}
+#if defined(BTN_TIMESTAMPS_USE) && !defined(BTN_TIMESTAMPS_EXTI_USE)
+	if (btn[id].raw_state != BTN_DEPRESSED) {
+		return;
+	}
+#endif
+	
+#if defined(BTN_DEBOUNCE_INTEGRATOR_USE)
+	if (btn[id].debounce_counter) {
+		return;
+	}
+#elif !defined(BTN_DEBOUNCE_POLICY_USE)
+	if (btn[id].press_counter) {
+		return;
+	}
+	
+	// Keep offset to phase instead of window position
+	btn[id].debounce_counter = (uint8_t) ((btn[id].debounce_counter + (BTN_DEBOUNCE_TRESHOLD + 1U) - phase) % (BTN_DEBOUNCE_TRESHOLD + 1U));
+#endif
+	(void) phase;
+	
+	btns_active[USER_IO_BIT_WORD(id)] &= ~USER_IO_BIT_MASK(id);
+}
+#endif
+#endif
+
+
+
+#ifdef LEDS_USE
+/**
+ * @fn void led_blink_infinite(enum led_id, uint16_t)
+ * @brief Applies infinite blinking effect to specified LED
+ * 
+ * @param id (enum led_id) LED to apply effect to
+ * @param blink_rate_ms (uint16_t) time in ms LED is on and off
+ */
+void led_blink_infinite(enum led_id id, uint16_t blink_rate_ms) {
+	led_request(LED_REQ_BLINK_INFINITE, id, blink_rate_ms, 0);
+}
+
+
+
+/**
+ * @fn void led_blink_ms(enum led_id, uint16_t, uint16_t)
+ * @brief Applies finite blinking effect to specified LED
+ * 
+ * @param id (enum led_id) LED to apply effect to
+ * @param blink_rate_ms (uint16_t) time in ms LED is on and off
+ * @param duration_ms (uint16_t) blinking effect time ms
+ */
+void led_blink_ms(enum led_id id, uint16_t blink_rate_ms, uint16_t duration_ms) {
+	led_request(LED_REQ_BLINK_MS, id, blink_rate_ms, duration_ms);
+}
+
+
+
+/**
+ * @fn void led_blink_n_times(enum led_id, uint16_t, uint16_t)
+ * @brief Applies finite blinking effect to specified LED
+ * 
+ * @param id (enum led_id) LED to apply effect to
+ * @param blink_rate_ms (uint16_t) time in ms LED is on and off
+ * @param n (uint16_t) how many times LED blinks
+ */
+void led_blink_n_times(enum led_id id, uint16_t blink_rate_ms, uint16_t n) {
+	led_request(LED_REQ_BLINK_N_TIMES, id, blink_rate_ms, n);
+}
+
+
+
+/**
+ * @fn void led_off(enum led_id)
+ * @brief Turns off specified LED
+ * 
+ * @param id (enum led_id) LED to turn off
+ * 
+ * @note Only applies to LEDs that are on or blinking infinitely,
+ * does not apply to finite effects. See led_force_off() for an alternative
+ */
+void led_off(enum led_id id) {
+	led_request(LED_REQ_OFF, id, 0, 0);
+}
+
+
+
+/**
+ * @fn void led_force_off(enum led_id)
+ * @brief Forces off specified LED no matter what effect is ongoing
+ * 
+ * @param id (enum led_id) LED to turn off
+ */
+void led_force_off(enum led_id id) {
+	led_request(LED_REQ_FORCE_OFF, id, 0, 0);
+}
+
+
+
+/**
+ * @fn void led_on(enum led_id)
+ * @brief Turns on specified LED
+ * 
+ * @param id (enum led_id) LED to turn on
+ */
+void led_on(enum led_id id) {
+	led_request(LED_REQ_ON, id, 0, 0);
+}
+
+
+
+/**
+ * @fn void led_pulse(enum led_id, uint16_t)
+ * @brief Pulse LED
+ * 
+ * @param id (enum led_id) LED to pulse
+ * @param pulse_duration_ms (uint16_t) how long LED is on ms
+ */
+void led_pulse(enum led_id id, uint16_t pulse_duration_ms) {
+	led_request(LED_REQ_PULSE, id, pulse_duration_ms, 0);
+}
+
+
+
+/**
+ * @fn void led_all_off(void)
+ * @brief Turn all LEDs off
+ * 
+ * @note Only applies to LEDs that are on or blinking infinitely,
+ * does not apply to finite effects. See led_all_force_off() for an alternative
+ */
+void led_all_off(void) {
+	led_request(LED_REQ_OFF, LED_REQ_ALL, 0, 0);
+}
+
+
+
+/**
+ * @fn void led_all_force_off(void)
+ * @brief Forces all LEDs off no matter what effect is ongoing
+ * 
+ */
+void led_all_force_off(void) {
+	led_request(LED_REQ_FORCE_OFF, LED_REQ_ALL, 0, 0);
+}
+
+
+
+/**
+ * @fn void led_all_on(void)
+ * @brief Turn all LEDs on
+ * 
+ */
+void led_all_on(void) {
+	led_request(LED_REQ_ON, LED_REQ_ALL, 0, 0);
+}
+
+
+
+/**
+ * @fn void led_all_blink_infinite(uint16_t)
+ * @brief Apply infinite blinking effect to all LEDs
+ * 
+ * @param blink_rate_ms (uint16_t) time in ms LEDs are on and off
+ */
+void led_all_blink_infinite(uint16_t blink_rate_ms) {
+	led_request(LED_REQ_BLINK_INFINITE, LED_REQ_ALL, blink_rate_ms, 0);
+}
+
+
+
+/**
+ * @fn void led_all_blink_n_times(uint16_t, uint16_t)
+ * @brief Apply finite blinking effect to all LEDs
+ * 
+ * @param blink_rate_ms (uint16_t) time in ms LEDs are on and off
+ * @param n (uint16_t) how many times LEDs blink
+ */
+void led_all_blink_n_times(uint16_t blink_rate_ms, uint16_t n) {
+	led_request(LED_REQ_BLINK_N_TIMES, LED_REQ_ALL, blink_rate_ms, n);
+}
+
+
+
+/**
+ * @fn void led_all_blink_ms(uint16_t, uint16_t)
+ * @brief Apply finite blinking effect to all LEDs
+ * 
+ * @param blink_rate_ms (uint16_t) time in ms LEDs are on and off
+ * @param duration_ms (uint16_t) blinking effect time ms
+ */
+void led_all_blink_ms(uint16_t blink_rate_ms, uint16_t duration_ms) {
+	led_request(LED_REQ_BLINK_MS, LED_REQ_ALL, blink_rate_ms, duration_ms);
+}
+
+
+
+/**
+ * @fn void led_all_pulse(uint16_t)
+ * @brief Pulse all LEDs
+ * 
+ * @param pulse_duration_ms (uint16_t) how long LEDs are on ms
+ */
+void led_all_pulse(uint16_t pulse_duration_ms) {
+	led_request(LED_REQ_PULSE, LED_REQ_ALL, pulse_duration_ms, 0);
+}
+
+
+
+#ifdef LED_QUEUE_USE
+/**
+ * @fn uint32_t leds_queue_dropped(void)
+ * @brief Returns LED requests dropped because the queue was full
+ * 
+ * @return (uint32_t)
+ * 
+ * @note Raise LED_QUEUE_SIZE if not 0, the queue is emptied every tick
+ */
+uint32_t leds_queue_dropped(void) {
+	return led_queue_drops;
+}
+#endif
+
+
+
+#ifdef LED_STATS_USE
+/**
+ * @fn uint32_t led_on_time_ms(enum led_id)
+ * @brief Returns time specified LED was driven on since init or last reset
+ * 
+ * @param id (enum led_id)
+ * @return (uint32_t)
+ * 
+ * @note Can count up to ~49 days, 2^32 ms, before overflow.
+ * With LED_WAVEFORM_USE, ticks are counted when rendered, up to LED_WAVEFORM_TICKS ahead
+ */
+uint32_t led_on_time_ms(enum led_id id) {
+	return led[id].on_ticks * USER_IO_HANDLER_PERIOD_MS;
+}
+
+
+
+/**
+ * @fn uint32_t led_changes(enum led_id)
+ * @brief Returns how many times specified LED turned on or off since init or last reset
+ * 
+ * @param id (enum led_id)
+ * @return (uint32_t)
+ */
+uint32_t led_changes(enum led_id id) {
+	return led[id].changes;
+}
+
+
+
+/**
+ * @fn uint32_t led_charge_uah(enum led_id)
+ * @brief Returns estimated charge drawn by specified LED since init or last reset
+ * 
+ * @param id (enum led_id)
+ * @return (uint32_t) charge in uAh, from LED_CURRENT_UA
+ */
+uint32_t led_charge_uah(enum led_id id) {
+	return (uint32_t) (((uint64_t) led[id].on_ticks * USER_IO_HANDLER_PERIOD_MS * led_current_ua[id]) / 3600000U);
+}
+
+
+
+/**
+ * @fn uint32_t leds_charge_uah(void)
+ * @brief Returns estimated charge drawn by all LEDs since init or last reset
+ * 
+ * @return (uint32_t) charge in uAh, from LED_CURRENT_UA
+ */
+uint32_t leds_charge_uah(void) {
+	uint64_t charge = 0;
+	
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		charge += (uint64_t) led[id].on_ticks * USER_IO_HANDLER_PERIOD_MS * led_current_ua[id];
+	}
+	
+	return (uint32_t) (charge / 3600000U);
+}
+
+
+
+/**
+ * @fn void led_stats_reset(enum led_id)
+ * @brief Restarts on-time and change counting of specified LED
+ * 
+ * @param id (enum led_id)
+ * 
+ * @note Queued like effects with LED_QUEUE_USE, counting restarts on next tick
+ */
+void led_stats_reset(enum led_id id) {
+#ifdef LED_QUEUE_USE
+	led_request(LED_REQ_STATS_RESET, id, 0, 0);
+#else
+	led_stats_clear(id);
+#endif
+}
+
+
+
+/**
+ * @fn void led_stats_clear(enum led_id)
+ * @brief Zeroes counters of specified LED, rewinds rendered ticks so they're counted again
+ * 
+ * @param id (enum led_id)
+ */
+static void led_stats_clear(enum led_id id) {
+#ifdef LED_WAVEFORM_USE
+	led_waveform_rewind();
+#endif
+#ifdef LEDS_SHED_USE
+	led_shed_sync(id);
+#endif
+
+	led[id].on_ticks = 0;
+	led[id].changes = 0;
+
+#ifdef LED_WAVEFORM_USE
+	led_waveform_forward();
+#endif
+}
+#endif
+
+
+
+#ifdef LED_RGB_USE
+/**
+ * @fn void led_color(enum led_id, uint8_t, uint8_t, uint8_t)
+ * @brief Sets color used by effects on specified LED
+ * 
+ * @param id (enum led_id) LED to set color of
+ * @param r (uint8_t) red
+ * @param g (uint8_t) green
+ * @param b (uint8_t) blue
+ * 
+ * @note Applies on next tick if LED is on, otherwise next time an effect turns it on.
+ * Safe against the handler without the queue: only the handler writes the frame, and
+ * it skips recoloring while led_rgb_color_seq is odd, so a half written color is never sent
+ */
+void led_color(enum led_id id, uint8_t r, uint8_t g, uint8_t b) {
+	led_rgb_color_seq++;
+	
+	// Stored in chain order
+	led[id].color[0] = g;
+	led[id].color[1] = r;
+	led[id].color[2] = b;
+	
+	led_rgb_recolor = true;
+	led_rgb_color_seq++;
+}
+
+
+
+/**
+ * @fn void led_all_color(uint8_t, uint8_t, uint8_t)
+ * @brief Sets color used by effects on all LEDs
+ * 
+ * @param r (uint8_t) red
+ * @param g (uint8_t) green
+ * @param b (uint8_t) blue
+ */
+void led_all_color(uint8_t r, uint8_t g, uint8_t b) {
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		led_color(id, r, g, b);
+	}
+}
+#endif
+
+
+
+#ifdef LED_MATRIX_USE
+/**
+ * @fn void led_matrix_scan(void)
+ * @brief Drives next used matrix row from frame written by effects
+ * 
+ * @note Called every tick by the handler, or from a faster timer with LED_MATRIX_EXTERNAL_SCAN
+ */
+void led_matrix_scan(void) {
+	uint8_t pos = led_matrix_scan_pos;
+	
+	if (led_matrix_rows_amount == 0) {
+		return;
+	}
+	
+	led_driver_matrix_row(led_matrix_row[pos], led_matrix_frame[led_matrix_row[pos]]);
+	led_matrix_scan_pos = (uint8_t) (((pos + 1) < led_matrix_rows_amount)? (pos + 1) : 0);
+}
+#endif
+
+
+
+/**
+ * @fn void leds_init(void)
+ * @brief Inits all LEDs with default params
+ * 
+ */
+static void leds_init(void) {
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		led[id].id = id;
+		led[id].set_state = OFF;
+		led[id].curr_state = OFF;
+		led[id].effect_counter = 0;
+		led[id].effect_rate = 0;	
+		led[id].effect_duration = 0;
+#ifdef LED_RGB_USE
+		led[id].color[0] = (uint8_t) (LED_RGB_DEFAULT_COLOR >> 8);	// G
+		led[id].color[1] = (uint8_t) (LED_RGB_DEFAULT_COLOR >> 16);	// R
+		led[id].color[2] = (uint8_t) LED_RGB_DEFAULT_COLOR;			// B
+#endif
+#ifdef LED_OUTPUT_TRACK_USE
+		led[id].output_on = false;
+#endif
+#ifdef LED_BUDGET_USE
+		led[id].lit = false;
+		led[id].lit_next = false;
+#endif
+#ifdef LED_STATS_USE
+		led[id].on_ticks = 0;
+		led[id].changes = 0;
+#endif
+	}
+
+#ifdef LED_RGB_USE
+	// Send chain off once
+	for (uint16_t i = 0; i < LED_RGB_FRAME_SIZE; i++) {
+		led_rgb_frame[i] = 0;
+	}
+	led_rgb_dirty = true;
+	led_rgb_pending = false;
+	led_rgb_sending = false;
+	led_rgb_color_seq = 0;
+	led_rgb_recolor = false;
+#endif
+
+#ifdef LED_MATRIX_USE
+	// Only rows with LEDs take a scan slot, lit LEDs get 1 / used rows duty
+	led_matrix_rows_amount = 0;
+	for (uint8_t row = 0; row < LED_MATRIX_ROWS; row++) {
+		led_matrix_frame[row] = 0;
+		
+		for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+			if (led_matrix_pos[id].row == row) {
+				led_matrix_row[led_matrix_rows_amount++] = row;
+				break;
+			}
+		}
+	}
+	led_matrix_scan_pos = 0;
+#endif
+
+#ifdef LED_BUDGET_USE
+	leds_budget_used = 0;
+	leds_budget_short = false;
+	leds_budget_next = 0;
+#endif
+
+#ifdef LED_QUEUE_USE
+	led_queue_head = 0;
+	led_queue_tail = 0;
+	led_queue_drops = 0;
+#endif
+
+#ifdef LED_WAVEFORM_USE
+	led_waveform_level = 0;
+	led_waveform_holds = 0;
+	leds_waveform_start();
+#endif
+}
+
+
+
+/**
+ * @fn void led_request(enum led_request, user_io_id_t, uint16_t, uint16_t)
+ * @brief Sets effect requested through API, queued for handler with LED_QUEUE_USE
+ * 
+ * @param request (enum led_request) effect
+ * @param id (user_io_id_t) LED, LED_REQ_ALL for every LED
+ * @param arg0 (uint16_t) rate or pulse duration in ms
+ * @param arg1 (uint16_t) blink duration in ms or amount of blinks
+ * 
+ * @note Queue has one writer, only call from main loop or a single task
+ */
+static void led_request(enum led_request request, user_io_id_t id, uint16_t arg0, uint16_t arg1) {
+#ifdef LED_QUEUE_USE
+	uint8_t head = led_queue_head;
+	
+	if ((uint8_t) (head - led_queue_tail) >= LED_QUEUE_SIZE) {
+		led_queue_drops++;
+		return;
+	}
+	
+	volatile struct led_cmd *cmd = &led_queue[head & (LED_QUEUE_SIZE - 1U)];
+	cmd->arg[0] = arg0;
+	cmd->arg[1] = arg1;
+	cmd->id = id;
+	cmd->request = (uint8_t) request;
+	
+	// Publish last, handler reads up to head only
+	led_queue_head = (uint8_t) (head + 1U);
+#else
+	if (id == LED_REQ_ALL) {
+		leds_set_all(request, arg0, arg1);
+	} else {
+		led_set(request, (enum led_id) id, arg0, arg1);
+	}
+#endif
+}
+
+
+
+/**
+ * @fn void led_set(enum led_request, enum led_id, uint16_t, uint16_t)
+ * @brief Applies effect to specified LED
+ * 
+ * @param request (enum led_request) effect
+ * @param id (enum led_id) LED to apply effect to
+ * @param arg0 (uint16_t) rate or pulse duration in ms
+ * @param arg1 (uint16_t) blink duration in ms or amount of blinks
+ */
+static void led_set(enum led_request request, enum led_id id, uint16_t arg0, uint16_t arg1) {
+#ifdef LED_WAVEFORM_USE
+	led_waveform_hold();
+#endif
+#ifdef LEDS_SHED_USE
+	led_shed_sync(id);
+#endif
+
+	switch (request) {
+		case LED_REQ_BLINK_INFINITE:
+			led[id].set_state = BLINK_INFINITE;
+			led[id].effect_rate = arg0;
+			break;
+			
+		case LED_REQ_BLINK_MS:
+			led[id].set_state = BLINK_MS;
+			led[id].effect_rate = arg0;
+			led[id].effect_duration = (int16_t) arg1;
+			break;
+			
+		case LED_REQ_BLINK_N_TIMES:
+			led[id].set_state = BLINK_N_TIMES;
+			led[id].effect_rate = arg0;
+			led[id].effect_duration = (int16_t) (arg1<<1); // Double, because off and on counts as 1 time each 
+			break;
+			
+		case LED_REQ_OFF:
+			// Let effects with duration finish
+			if ((led[id].set_state == ON) || (led[id].set_state == BLINK_INFINITE)) {
+				led[id].set_state = OFF;
+				
+				// Makes sure start of blink effect is the same
+				led[id].effect_counter = 0;
+			}
+			break;
+			
+		case LED_REQ_FORCE_OFF:
+			led[id].set_state = OFF;
+			
+			// Makes sure start of blink effect is the same
+			led[id].effect_counter = 0;
+			break;
+			
+		case LED_REQ_ON:
+			led[id].set_state = ON;
+			break;
+			
+		case LED_REQ_PULSE:
+			led[id].set_state = PULSE;
+			led[id].effect_duration = (int16_t) arg0;
+			break;
+			
+		case LED_REQ_STATS_RESET:
+			break;
+	}
+
+#ifdef LEDS_SPARSE_USE
+	led_wake(id);
+#endif
+
+#ifdef LED_WAVEFORM_USE
+	led_waveform_release();
+#endif
+}
+
+
+
+/**
+ * @fn void leds_set_all(enum led_request, uint16_t, uint16_t)
+ * @brief Applies effect to all LEDs
+ * 
+ * @param request (enum led_request) effect
+ * @param arg0 (uint16_t) rate or pulse duration in ms
+ * @param arg1 (uint16_t) blink duration in ms or amount of blinks
+ */
+static void leds_set_all(enum led_request request, uint16_t arg0, uint16_t arg1) {
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		led_set(request, id, arg0, arg1);
+	}
+
+#ifdef LED_BUDGET_USE
+	if ((request == LED_REQ_BLINK_INFINITE) || (request == LED_REQ_BLINK_MS) || (request == LED_REQ_BLINK_N_TIMES)) {
+		leds_budget_phase(arg0);
+	}
+#endif
+}
+
+
+
+/**
+ * @fn void leds_handle_effects(void)
+ * @brief Apply effects and animate them for all LEDs
+ * 
+ */
+static void leds_handle_effects(void) {
+#ifdef LEDS_SPARSE_USE
+	for (uint16_t word = 0; word < USER_IO_BITMAP_WORDS(LEDS_AMOUNT); word++) {
+		uint32_t walk = leds_active[word];
+		
+		while (walk) {
+			user_io_id_t id = (user_io_id_t) ((word << 5) + USER_IO_CTZ(walk));
+			
+			walk &= walk - 1;
+			led_handle_effect(id);
+			led_settle(id);
+		}
+	}
+#else
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		led_handle_effect(id);
+	}
+#endif
+}
+
+
+
+/**
+ * @fn void led_handle_effect(enum led_id)
+ * @brief Apply and animate effect of specified LED for one tick
+ * 
+ * @param id (enum led_id) LED
+ */
+static void led_handle_effect(enum led_id id) {
+	switch (led[id].set_state) {
+	
+		case BLINK_INFINITE:
+			led_handle_effect_blink_infinite(id);
+			break;				
+			
+		case BLINK_MS:
+			led_handle_effect_blink_ms(id);
+			break;
+					
+		case BLINK_N_TIMES:
+			led_handle_effect_blink_n_times(id);
+			break;
+											
+		case OFF:
+			led_handle_effect_off(id);
+			break;
+										
+		case PULSE:
+			led_handle_effect_pulse(id);
+			break;
+			
+		case ON:
+			led_handle_effect_on(id);
+			break;
+	}
+	
+#ifdef LED_STATS_USE
+	led[id].on_ticks += led[id].output_on;
+#endif
+}
+
+
+
+/**
+ * @fn void led_effect_blink_infinite(enum led_id)
+ * @brief Handles blink infinite effect
+ * 
+ * @param id (enum led_id) LED
+ */
+static void led_handle_effect_blink_infinite(enum led_id id) {
+	// Time to toggle
+	if (led[id].effect_counter <= 0) {
+		led_output_toggle(id);
+		led[id].curr_state = BLINK_INFINITE;
+		
+		// Reset counter
+		led[id].effect_counter = (int16_t) led[id].effect_rate;
+	}
+	
+	// Remaining time to toggle
+	led[id].effect_counter -= USER_IO_HANDLER_PERIOD_MS;
+}
+
+
+
+/**
+ * @fn void led_handle_effect_blink_ms(enum led_id)
+ * @brief Handles blink ms effect
+ * 
+ * @param id (enum led_id) LED
+ */
+static void led_handle_effect_blink_ms(enum led_id id) {
+	// Effect is done
+	if (led[id].effect_duration <= 0) {
+		led_output_off(id);
+		
+		led[id].set_state = OFF;
+		led[id].curr_state = OFF;
+		return;
+	}
+	
+	// Calc remaining effect time
+	led[id].effect_duration -= USER_IO_HANDLER_PERIOD_MS;
+	
+	// Time to toggle
+	if (led[id].effect_counter <= 0) {
+		led_output_toggle(id);
+		led[id].curr_state = BLINK_MS;
+		
+		// Reset counter
+		led[id].effect_counter = (int16_t) led[id].effect_rate;
+	}
+	
+	// Remaining time to toggle
+	led[id].effect_counter -= USER_IO_HANDLER_PERIOD_MS;
+}
+
+
+
+/**
+ * @fn void led_handle_effect_blink_n_times(enum led_id)
+ * @brief Handles blink n times effect
+ * 
+ * @param id (enum led_id) LED
+ */
+static void led_handle_effect_blink_n_times(enum led_id id) {
+	// N times reached
+	if (led[id].effect_duration <= 0) {
+		led_output_off(id);
+		
+		led[id].set_state = OFF;
+		led[id].curr_state = OFF;
+		return;
+	}
+	
+	// Time to toggle
+	if (led[id].effect_counter <= 0) {
+		led_output_toggle(id);
+		led[id].curr_state = BLINK_N_TIMES;
+		
+		// Reset counter
+		led[id].effect_counter = (int16_t) led[id].effect_rate;
+
+		// Update total blinks left
+		led[id].effect_duration--;
+	}
+	
+	// Remaining time to toggle
+	led[id].effect_counter -= USER_IO_HANDLER_PERIOD_MS;
+}
+
+
+
+/**
+ * @fn void led_handle_effect_off(enum led_id)
+ * @brief Handles off effect
+ * 
+ * @param id (enum led_id) LED
+ */
+static void led_handle_effect_off(enum led_id id) {
+	if (led[id].curr_state != OFF) {
+		led_output_off(id);	
+		led[id].curr_state = OFF;
+	} 
+}
+
+
+
+/**
+ * @fn void led_handle_effect_pulse(enum led_id)
+ * @brief Handles pulse effect
+ * 
+ * @param id (enum led_id) LED
+ */
+static void led_handle_effect_pulse(enum led_id id) {
+	// Pulse effect done
+	if (led[id].effect_duration <= 0) {
+		led_output_off(id);
+		
+		led[id].set_state = OFF;
+		led[id].curr_state = OFF;
+		return;
+		
+	// Start pulse effect
+	} else if (led[id].curr_state != PULSE) {
+		led_output_on(id);
+		
+		led[id].curr_state = PULSE;
+	}
+		
+	// Remaining effect time
+	led[id].effect_duration -= USER_IO_HANDLER_PERIOD_MS;	
+}
+
+
+
+/**
+ * @fn void led_handle_effect_on(enum led_id)
+ * @brief Handles on effect
+ * 
+ * @param id (enum led_id) LED
+ */
+static void led_handle_effect_on(enum led_id id) {
+	if (led[id].curr_state != ON) {
+		led_output_on(id);
+		led[id].curr_state = ON;
+	}
+}
+
+
+
+/**
+ * @fn void led_output_on(enum led_id)
+ * @brief Turns on LED from effect engine
+ * 
+ * @param id (enum led_id) LED
+ */
+static void led_output_on(enum led_id id) {
+#ifdef LED_STATS_USE
+	led[id].changes += !led[id].output_on;
+#endif
+#ifdef LED_OUTPUT_TRACK_USE
+	led[id].output_on = true;
+#endif
+
+#ifdef LED_RGB_USE
+	led_rgb_write(id, led[id].color);
+#elif defined(LED_WAVEFORM_USE)
+	led_waveform_level |= LED_WAVEFORM_SET(id);
+	
+	// Written into tick being rendered, discarded when syncing
+	if (led_waveform_word) {
+		*led_waveform_word = (*led_waveform_word & ~LED_WAVEFORM_RESET(id)) | LED_WAVEFORM_SET(id);
+	}
+#elif defined(LED_MATRIX_USE)
+	led_matrix_frame[led_matrix_pos[id].row] |= LED_MATRIX_BIT(id);
+#elif defined(LED_BUDGET_USE)
+	led_budget_on(id);
+#else
+	led_driver_on(id);
+#endif
+}
+
+
+
+/**
+ * @fn void led_output_off(enum led_id)
+ * @brief Turns off LED from effect engine
+ * 
+ * @param id (enum led_id) LED
+ */
+static void led_output_off(enum led_id id) {
+#ifdef LED_STATS_USE
+	led[id].changes += led[id].output_on;
+#endif
+#ifdef LED_OUTPUT_TRACK_USE
+	led[id].output_on = false;
+#endif
+
+#ifdef LED_RGB_USE
+	static const uint8_t black[LED_RGB_BYTES_PER_PIXEL] = {0};
+	
+	led_rgb_write(id, black);
+#elif defined(LED_WAVEFORM_USE)
+	led_waveform_level &= ~LED_WAVEFORM_SET(id);
+	
+	// Written into tick being rendered, discarded when syncing
+	if (led_waveform_word) {
+		*led_waveform_word = (*led_waveform_word & ~LED_WAVEFORM_SET(id)) | LED_WAVEFORM_RESET(id);
+	}
+#elif defined(LED_MATRIX_USE)
+	led_matrix_frame[led_matrix_pos[id].row] &= ~LED_MATRIX_BIT(id);
+#elif defined(LED_BUDGET_USE)
+	led_budget_off(id);
+#else
+	led_driver_off(id);
+#endif
+}
+
+
+
+/**
+ * @fn void led_output_toggle(enum led_id)
+ * @brief Toggles LED from effect engine
+ * 
+ * @param id (enum led_id) LED
+ */
+static void led_output_toggle(enum led_id id) {
+#if defined(LED_RGB_USE)
+	if (led[id].output_on) {
+		led_output_off(id);
+	} else {
+		led_output_on(id);
+	}
+#elif defined(LED_WAVEFORM_USE)
+	if (led_waveform_level & LED_WAVEFORM_SET(id)) {
+		led_output_off(id);
+	} else {
+		led_output_on(id);
+	}
+#else
+#ifdef LED_STATS_USE
+	led[id].changes++;
+#endif
+#ifdef LED_OUTPUT_TRACK_USE
+	led[id].output_on = !led[id].output_on;
+#endif
+#if defined(LED_MATRIX_USE)
+	led_matrix_frame[led_matrix_pos[id].row] ^= LED_MATRIX_BIT(id);
+#elif defined(LED_BUDGET_USE)
+	if (led[id].output_on) {
+		led_budget_on(id);
+	} else {
+		led_budget_off(id);
+	}
+#else
+	led_driver_toggle(id);
+#endif
+#endif
+}
+
+
+
+/**
+ * @fn void leds_handle_elapsed(uint32_t)
+ * @brief Advances effects of all LEDs as if they were handled ticks times
+ * 
+ * @param ticks (uint32_t) ticks elapsed
+ */
+static void leds_handle_elapsed(uint32_t ticks) {
+#ifdef LEDS_SPARSE_USE
+	for (uint16_t word = 0; word < USER_IO_BITMAP_WORDS(LEDS_AMOUNT); word++) {
+		uint32_t walk = leds_active[word];
+		
+		while (walk) {
+			user_io_id_t id = (user_io_id_t) ((word << 5) + USER_IO_CTZ(walk));
+			
+			walk &= walk - 1;
+			led_handle_elapsed(id, ticks);
+			led_settle(id);
+		}
+	}
+#else
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		led_handle_elapsed(id, ticks);
+	}
+#endif
+}
+
+
+
+/**
+ * @fn void led_handle_elapsed(enum led_id, uint32_t)
+ * @brief Advances effect of specified LED as if it was handled ticks times
+ * 
+ * @param id (enum led_id) LED
+ * @param ticks (uint32_t) ticks elapsed
+ */
+static void led_handle_elapsed(enum led_id id, uint32_t ticks) {
+	uint32_t toggles;
+	
+	switch (led[id].set_state) {
+	
+		case BLINK_INFINITE:
+			led_elapsed_blink(id, ticks, 0xFFFFFFFFU, &toggles);
+			break;				
+			
+		case BLINK_MS:
+			led_elapsed_blink_ms(id, ticks);
+			break;
+					
+		case BLINK_N_TIMES:
+			led_elapsed_blink_n_times(id, ticks);
+			break;
+											
+		case OFF:
+			led_handle_effect_off(id);
+			break;
+										
+		case PULSE:
+			led_elapsed_pulse(id, ticks);
+			break;
+			
+		case ON:
+			led_handle_effect_on(id);
+#ifdef LED_STATS_USE
+			led[id].on_ticks += ticks;
+#endif
+			break;
+	}
+}
+
+
+
+#ifdef LEDS_SPARSE_USE
+/**
+ * @fn void led_wake(enum led_id)
+ * @brief Marks specified LED as active after its effect was changed
+ * 
+ * @param id (enum led_id) LED
+ * 
+ * @note Called after effect is set, handler either sees new effect or misses it until next tick
+ */
+static void led_wake(enum led_id id) {
+	leds_active[USER_IO_BIT_WORD(id)] |= USER_IO_BIT_MASK(id);
+}
+
+
+
+/**
+ * @fn void led_settle(enum led_id)
+ * @brief Marks specified LED as idle once steady on or off, it's skipped until its effect changes
+ * 
+ * @param id (enum led_id) LED
+ * 
+ * @note LEDs that are on stay active with LED_STATS_USE, their on-time keeps counting
+ */
+static void led_settle(enum led_id id) {
+	enum led_state state = led[id].set_state;
+	
+	if (((state != OFF) && (state != ON)) || (led[id].curr_state != state)) {
+		return;
+	}
+#ifdef LED_STATS_USE
+	if (state == ON) {
+		return;
+	}
+#endif
+	
+	leds_active[USER_IO_BIT_WORD(id)] &= ~USER_IO_BIT_MASK(id);
+}
+#endif
+
+
+
+#ifdef LED_QUEUE_USE
+/**
+ * @fn void leds_queue_apply(void)
+ * @brief Applies LED requests queued since last tick, in order
+ * 
+ */
+static void leds_queue_apply(void) {
+	uint8_t head = led_queue_head;
+	uint8_t tail = led_queue_tail;
+	
+	while (tail != head) {
+		volatile struct led_cmd *cmd = &led_queue[tail & (LED_QUEUE_SIZE - 1U)];
+		
+		if (cmd->id == LED_REQ_ALL) {
+			leds_set_all((enum led_request) cmd->request, cmd->arg[0], cmd->arg[1]);
+#ifdef LED_STATS_USE
+		} else if (cmd->request == LED_REQ_STATS_RESET) {
+			led_stats_clear((enum led_id) cmd->id);
+#endif
+		} else {
+			led_set((enum led_request) cmd->request, (enum led_id) cmd->id, cmd->arg[0], cmd->arg[1]);
+		}
+		tail++;
+	}
+	
+	// Free slots once applied
+	led_queue_tail = tail;
+}
+#endif
+
+
+
+#ifdef LED_BUDGET_USE
+/**
+ * @fn void led_budget_on(enum led_id)
+ * @brief Lights specified LED if it fits in budget, otherwise it waits for its turn
+ * 
+ * @param id (enum led_id) LED
+ * 
+ * @note LED costing more than whole budget is never lit and doesn't wait,
+ * it would keep slicing going forever
+ */
+static void led_budget_on(enum led_id id) {
+	if (led[id].lit || !LED_BUDGET_FITS(id)) {
+		return;
+	}
+	
+	if ((leds_budget_used + LED_BUDGET_COST(id)) > LED_BUDGET_LIMIT) {
+		leds_budget_short = true;
+		return;
+	}
+	
+	led[id].lit = true;
+	leds_budget_used += LED_BUDGET_COST(id);
+	led_driver_on(id);
+}
+
+
+
+/**
+ * @fn void led_budget_off(enum led_id)
+ * @brief Turns off specified LED and frees its share of budget
+ * 
+ * @param id (enum led_id) LED
+ */
+static void led_budget_off(enum led_id id) {
+	if (!led[id].lit) {
+		return;
+	}
+	
+	led[id].lit = false;
+	leds_budget_used -= LED_BUDGET_COST(id);
+	led_driver_off(id);
+}
+
+
+
+/**
+ * @fn void leds_budget_slice(void)
+ * @brief Gives LEDs waiting to be lit a turn, in round robin from where last slice stopped
+ * 
+ * @note Only runs while LEDs wait. LEDs are turned off before others are lit,
+ * so budget holds between pin writes too. user_io_handler_elapsed() runs one slice
+ * for all its ticks, turns go on from there instead of where ticks one by one would be
+ */
+static void leds_budget_slice(void) {
+	if (!leds_budget_short) {
+		return;
+	}
+	
+	uint32_t used = 0;
+	bool short_now = false;
+	user_io_id_t id = leds_budget_next;
+	user_io_id_t last = leds_budget_next;
+	
+	for (user_io_id_t n = 0; n < LEDS_AMOUNT; n++) {
+		led[id].lit_next = false;
+		
+		if (led[id].output_on && LED_BUDGET_FITS(id)) {
+			if ((used + LED_BUDGET_COST(id)) <= LED_BUDGET_LIMIT) {
+				led[id].lit_next = true;
+				used += LED_BUDGET_COST(id);
+				last = id;
+			} else {
+				short_now = true;
+			}
+		}
+		id = (user_io_id_t) ((id + 1U) % LEDS_AMOUNT);
+	}
+	
+	for (id = 0; id < LEDS_AMOUNT; id++) {
+		if (!led[id].lit_next) {
+			led_budget_off(id);
+		}
+	}
+	for (id = 0; id < LEDS_AMOUNT; id++) {
+		if (led[id].lit_next) {
+			led_budget_on(id);
+		}
+	}
+	
+	leds_budget_short = short_now;
+	leds_budget_next = (user_io_id_t) ((last + 1U) % LEDS_AMOUNT);
+}
+
+
+
+/**
+ * @fn void leds_budget_phase(uint16_t)
+ * @brief Starts blinks of LEDs that don't fit in budget together half a period late
+ * 
+ * @param blink_rate_ms (uint16_t) time in ms LEDs are on and off
+ * 
+ * @note Only LEDs about to start blinking from off are shifted, running blinks keep their phase.
+ * LEDs fitting in neither phase start on time and are time sliced
+ */
+static void leds_budget_phase(uint16_t blink_rate_ms) {
+	uint32_t load[LED_BUDGET_PHASES] = {0};
+	uint8_t phase = 0;
+	
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		if (led[id].output_on || (led[id].effect_counter > 0)) {
+			continue;
+		}
+		
+		// Stay in a phase while LEDs fit, then move on to the next phase with room
+		uint8_t tried = 0;
+		
+		while (((load[phase] + LED_BUDGET_COST(id)) > LED_BUDGET_LIMIT) && (tried < LED_BUDGET_PHASES)) {
+			phase = (uint8_t) ((phase + 1U) % LED_BUDGET_PHASES);
+			tried++;
+		}
+		
+		if (tried == LED_BUDGET_PHASES) {
+			continue;
+		}
+		load[phase] += LED_BUDGET_COST(id);
+		
+		if (phase) {
+			led[id].effect_counter = (int16_t) blink_rate_ms;
+		}
+	}
+}
+#endif
+
+
+
+/**
+ * @fn uint32_t led_elapsed_blink(enum led_id, uint32_t, uint32_t, uint32_t*)
+ * @brief Advances blink counter of specified LED by ticks and applies resulting toggles at once
+ * 
+ * @param id (enum led_id) LED
+ * @param ticks (uint32_t) ticks elapsed
+ * @param max_toggles (uint32_t) toggles left in effect
+ * @param toggles (uint32_t*) toggles done
+ * @return (uint32_t) tick of last toggle, 1 being first elapsed tick, 0 if none
+ */
+static uint32_t led_elapsed_blink(enum led_id id, uint32_t ticks, uint32_t max_toggles, uint32_t *toggles) {
+	int32_t counter = led[id].effect_counter;
+	int32_t rate = (int16_t) led[id].effect_rate;
+	
+	// Ticks until first toggle and between toggles
+	uint32_t first = (counter <= 0)? 1 : (((uint32_t) counter + USER_IO_HANDLER_PERIOD_MS - 1) / USER_IO_HANDLER_PERIOD_MS) + 1;
+	uint32_t every = (rate <= 0)? 1 : (((uint32_t) rate + USER_IO_HANDLER_PERIOD_MS - 1) / USER_IO_HANDLER_PERIOD_MS);
+	
+	*toggles = 0;
+	
+	if ((ticks < first) || (max_toggles == 0)) {
+		led[id].effect_counter = (int16_t) (counter - (int32_t) (ticks * USER_IO_HANDLER_PERIOD_MS));
+#ifdef LED_STATS_USE
+		led[id].on_ticks += led[id].output_on * ticks;
+#endif
+		return 0;
+	}
+	
+	uint32_t n = 1 + ((ticks - first) / every);
+	if (n > max_toggles) {
+		n = max_toggles;
+	}
+	uint32_t last = first + ((n - 1) * every);
+	
+	// Effect ends with last toggle, counter stops there
+	uint32_t end = (n == max_toggles)? last : ticks;
+	
+#ifdef LED_STATS_USE
+	led_stats_add_blink(id, first, every, n, end);
+#endif
+
+	// Even amount of toggles leaves LED as it was
+	if (n & 1U) {
+		led_output_toggle(id);
+	}
+	led[id].curr_state = led[id].set_state;
+	
+	led[id].effect_counter = (int16_t) (rate - (int32_t) ((end - last + 1) * USER_IO_HANDLER_PERIOD_MS));
+	*toggles = n;
+	
+	return last;
+}
+
+
+
+/**
+ * @fn void led_elapsed_blink_ms(enum led_id, uint32_t)
+ * @brief Advances blink ms effect by ticks
+ * 
+ * @param id (enum led_id) LED
+ * @param ticks (uint32_t) ticks elapsed
+ */
+static void led_elapsed_blink_ms(enum led_id id, uint32_t ticks) {
+	int32_t duration = led[id].effect_duration;
+	uint32_t active = (duration <= 0)? 0 : (((uint32_t) duration + USER_IO_HANDLER_PERIOD_MS - 1) / USER_IO_HANDLER_PERIOD_MS);
+	uint32_t toggles;
+	
+	if (active > ticks) {
+		active = ticks;
+	}
+	
+	led[id].effect_duration = (int16_t) (duration - (int32_t) (active * USER_IO_HANDLER_PERIOD_MS));
+	led_elapsed_blink(id, active, 0xFFFFFFFFU, &toggles);
+	
+	// Effect ran out, turns off on next tick
+	if (ticks > active) {
+		led_handle_effect_blink_ms(id);
+	}
+}
+
+
+
+/**
+ * @fn void led_elapsed_blink_n_times(enum led_id, uint32_t)
+ * @brief Advances blink n times effect by ticks
+ * 
+ * @param id (enum led_id) LED
+ * @param ticks (uint32_t) ticks elapsed
+ */
+static void led_elapsed_blink_n_times(enum led_id id, uint32_t ticks) {
+	int32_t left = led[id].effect_duration;
+	uint32_t toggles;
+	
+	if (left <= 0) {
+		led_handle_effect_blink_n_times(id);
+		return;
+	}
+	
+	uint32_t last = led_elapsed_blink(id, ticks, (uint32_t) left, &toggles);
+	led[id].effect_duration = (int16_t) (left - (int32_t) toggles);
+	
+	// N times reached before last tick, turns off on next tick
+	if ((toggles == (uint32_t) left) && (ticks > last)) {
+		led_handle_effect_blink_n_times(id);
+	}
+}
+
+
+
+/**
+ * @fn void led_elapsed_pulse(enum led_id, uint32_t)
+ * @brief Advances pulse effect by ticks
+ * 
+ * @param id (enum led_id) LED
+ * @param ticks (uint32_t) ticks elapsed
+ */
+static void led_elapsed_pulse(enum led_id id, uint32_t ticks) {
+	int32_t duration = led[id].effect_duration;
+	
+	if (duration <= 0) {
+		led_handle_effect_pulse(id);
+		return;
+	}
+	
+	uint32_t active = ((uint32_t) duration + USER_IO_HANDLER_PERIOD_MS - 1) / USER_IO_HANDLER_PERIOD_MS;
+	if (active > ticks) {
+		active = ticks;
+	}
+	
+	if (led[id].curr_state != PULSE) {
+		led_output_on(id);
+		led[id].curr_state = PULSE;
+	}
+#ifdef LED_STATS_USE
+	led[id].on_ticks += active;
+#endif
+	led[id].effect_duration = (int16_t) (duration - (int32_t) (active * USER_IO_HANDLER_PERIOD_MS));
+	
+	// Pulse ran out, turns off on next tick
+	if (ticks > active) {
+		led_handle_effect_pulse(id);
+	}
+}
+
+
+
+#ifdef LED_STATS_USE
+/**
+ * @fn void led_stats_add_blink(enum led_id, uint32_t, uint32_t, uint32_t, uint32_t)
+ * @brief Adds on-time and changes of toggles done at once, before they are applied
+ * 
+ * @param id (enum led_id) LED
+ * @param first (uint32_t) tick of first toggle
+ * @param every (uint32_t) ticks between toggles
+ * @param toggles (uint32_t) amount of toggles, at least 1
+ * @param end (uint32_t) last tick counted
+ */
+static void led_stats_add_blink(enum led_id id, uint32_t first, uint32_t every, uint32_t toggles, uint32_t end) {
+	uint32_t was_on = led[id].output_on;
+	uint32_t last = first + ((toggles - 1) * every);
+	
+	// Level before first toggle, full periods between toggles alternate starting with other level
+	uint32_t on_ticks = was_on * (first - 1);
+	on_ticks += (was_on? ((toggles - 1) / 2) : (toggles / 2)) * every;
+	on_ticks += (was_on ^ (toggles & 1U)) * (end - last + 1);
+	
+	led[id].on_ticks += on_ticks;
+	
+	// Applied as a single toggle at most
+	led[id].changes += toggles - (toggles & 1U);
+}
+#endif
+
+
+
+#ifdef LEDS_SHED_USE
+/**
+ * @fn void leds_shed_begin(void)
+ * @brief Starts updating LEDs in turns, all LEDs are up to date
+ * 
+ */
+static void leds_shed_begin(void) {
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		led_shed_tick[id] = leds_shed_tick;
+	}
+}
+
+
+
+/**
+ * @fn void leds_handle_shed(uint32_t)
+ * @brief Updates USER_IO_SHED_LEDS_PER_TICK LEDs in turn, each catches up on ticks since its last turn
+ * 
+ * @param ticks (uint32_t) ticks elapsed
+ */
+static void leds_handle_shed(uint32_t ticks) {
+	leds_shed_tick += ticks;
+	
+	for (uint8_t n = 0; (n < USER_IO_SHED_LEDS_PER_TICK) && (n < LEDS_AMOUNT); n++) {
+		user_io_id_t id = leds_shed_next;
+		
+		// Skipped while caught up from main, ticks stay pending
+		if (led_shed_syncing != (id + 1)) {
+			led_handle_elapsed(id, leds_shed_tick - led_shed_tick[id]);
+			led_shed_tick[id] = leds_shed_tick;
+		}
+		
+		leds_shed_next = (user_io_id_t) ((id + 1) % LEDS_AMOUNT);
+	}
+}
+
+
+
+/**
+ * @fn bool leds_shed_end(void)
+ * @brief Catches up all LEDs, back to updating every LED every tick
+ * 
+ * @return (bool) false if a LED is being caught up from main, try again next tick
+ */
+static bool leds_shed_end(void) {
+	if (led_shed_syncing) {
+		return false;
+	}
+	
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		if (leds_shed_tick != led_shed_tick[id]) {
+			led_handle_elapsed(id, leds_shed_tick - led_shed_tick[id]);
+		}
+	}
+	return true;
+}
+
+
+
+/**
+ * @fn void led_shed_sync(enum led_id)
+ * @brief Catches up specified LED before its effect is changed
+ * 
+ * @param id (enum led_id) LED
+ * 
+ * @note Pending ticks would otherwise be applied to the new effect
+ */
+static void led_shed_sync(enum led_id id) {
+	if (!user_io_shedding) {
+		return;
+	}
+	
+	led_shed_syncing = (user_io_id_t) (id + 1);
+	
+	uint32_t tick = leds_shed_tick;
+	if (tick != led_shed_tick[id]) {
+		led_handle_elapsed(id, tick - led_shed_tick[id]);
+		led_shed_tick[id] = tick;
+	}
+	
+	led_shed_syncing = 0;
+}
+#endif
+#endif
+
+
+
+#ifdef LED_WAVEFORM_USE
+/**
+ * @fn void led_waveform_half_done(void)
+ * @brief Hands half of waveform buffer that was just played out back for rendering
+ * 
+ * @note Call from DMA half transfer and transfer complete interrupts, see led_driver_waveform_start()
+ */
+void led_waveform_half_done(void) {
+	led_waveform_played++;
+}
+
+
+
+/**
+ * @fn void leds_waveform_start(void)
+ * @brief Renders both halves from current LED states and starts playing them out
+ * 
+ */
+static void leds_waveform_start(void) {
+	led_waveform_rendered = 0;
+	led_waveform_played = 0;
+	led_waveform_seen = 0;
+	led_waveform_pos = 0;
+	
+	leds_waveform_render();
+	leds_waveform_render();
+	
+	led_driver_waveform_start(led_waveform_buf, LED_WAVEFORM_TICKS);
+}
+
+
+
+/**
+ * @fn void leds_handle_waveform(uint32_t)
+ * @brief Renders halves played out since last tick and tracks playback position
+ * 
+ * @param ticks (uint32_t) ticks elapsed, 1 from handler
+ * 
+ * @note Effect logic only runs on refill, once per LED_WAVEFORM_TICKS / 2 ticks
+ */
+static void leds_handle_waveform(uint32_t ticks) {
+	uint16_t played = led_waveform_played;
+	
+	// Position is only used to rewind, a boundary within skipped ticks restarts it
+	if (played != led_waveform_seen) {
+		led_waveform_seen = played;
+		led_waveform_pos = 0;
+	} else if ((led_waveform_pos + ticks) < LED_WAVEFORM_HALF) {
+		led_waveform_pos = (uint16_t) (led_waveform_pos + ticks);
+	} else {
+		led_waveform_pos = LED_WAVEFORM_HALF - 1;
+	}
+	
+	if (led_waveform_holds) {
+		return;
+	}
+	
+	// Half being played out was never rendered, its effects are skipped
+	if ((int16_t) (led_waveform_rendered - played) < 1) {
+		led_waveform_word = 0;
+		leds_handle_elapsed((uint32_t) (uint16_t) (played + 1U - led_waveform_rendered) * LED_WAVEFORM_HALF);
+		led_waveform_rendered = (uint16_t) (played + 1U);
+	}
+	
+	// One half is played out while the other waits, only a half played out is rewritten
+	while ((uint16_t) (led_waveform_rendered - played) < 2) {
+		leds_waveform_render();
+	}
+}
+
+
+
+/**
+ * @fn void leds_waveform_render(void)
+ * @brief Renders next LED_WAVEFORM_TICKS / 2 ticks of all effects into set/reset words of the free half
+ * 
+ */
+static void leds_waveform_render(void) {
+	uint8_t half = (uint8_t) (led_waveform_rendered & 1U);
+	uint32_t *buf = &led_waveform_buf[half * LED_WAVEFORM_HALF];
+	uint32_t first_level = 0;
+	
+#if defined(USER_IO_RETAIN_USE) || defined(LED_STATS_USE)
+	// Keep half start to be able to rewind to any tick within it
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		led_waveform_start[half][id] = led[id];
+	}
+	led_waveform_level_start[half] = led_waveform_level;
+#endif
+	
+	for (uint16_t tick = 0; tick < LED_WAVEFORM_HALF; tick++) {
+		led_waveform_word = &buf[tick];
+		*led_waveform_word = 0;
+		leds_handle_effects();
+		
+		if (tick == 0) {
+			first_level = led_waveform_level;
+		}
+	}
+	led_waveform_word = 0;
+	
+	// First word drives all levels, pins are left behind if a half was skipped
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		buf[0] |= (first_level & LED_WAVEFORM_SET(id))? LED_WAVEFORM_SET(id) : LED_WAVEFORM_RESET(id);
+	}
+	
+	led_waveform_rendered++;
+}
+
+
+
+/**
+ * @fn void led_waveform_hold(void)
+ * @brief Holds off rendering while an effect is changed, calls nest
+ * 
+ * @note LED states are at end of last rendered half, a change shows from the next half rendered
+ */
+static void led_waveform_hold(void) {
+	led_waveform_holds++;
+}
+
+
+
+/**
+ * @fn void led_waveform_release(void)
+ * @brief Ends led_waveform_hold(), rendering resumes on next tick
+ * 
+ */
+static void led_waveform_release(void) {
+	led_waveform_holds--;
+}
+
+
+
+#if defined(USER_IO_RETAIN_USE) || defined(LED_STATS_USE)
+/**
+ * @fn void led_waveform_rewind(void)
+ * @brief Brings LED states back to tick being played out and holds off rendering
+ * 
+ * @note Must be followed by led_waveform_forward()
+ */
+static void led_waveform_rewind(void) {
+	led_waveform_hold();
+	
+	uint16_t played = led_waveform_played;
+	uint16_t pos = led_waveform_pos;
+	uint8_t half = (uint8_t) (played & 1U);
+	
+	// Nothing rendered ahead if rendering fell behind
+	led_waveform_replay = 0;
+	if ((int16_t) (led_waveform_rendered - played) < 1) {
+		return;
+	}
+	
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		led[id] = led_waveform_start[half][id];
+	}
+	led_waveform_level = led_waveform_level_start[half];
+	
+	// Replay ticks already played out, output is discarded
+	for (uint16_t tick = 0; tick < pos; tick++) {
+		leds_handle_effects();
+	}
+	led_waveform_replay = ((uint32_t) (uint16_t) (led_waveform_rendered - played) * LED_WAVEFORM_HALF) - pos;
+}
+
+
+
+/**
+ * @fn void led_waveform_forward(void)
+ * @brief Brings LED states back to end of last rendered half after led_waveform_rewind()
+ * 
+ */
+static void led_waveform_forward(void) {
+	for (; led_waveform_replay; led_waveform_replay--) {
+		leds_handle_effects();
+	}
+	led_waveform_release();
+}
+#endif
+#endif
+
+
+
+#ifdef LED_RGB_USE
+/**
+ * @fn void led_rgb_write(enum led_id, const uint8_t*)
+ * @brief Writes pixel of specified LED to frame buffer, marks frame dirty if changed
+ * 
+ * @param id (enum led_id) LED
+ * @param grb (const uint8_t*) color in chain order
+ */
+static void led_rgb_write(enum led_id id, const uint8_t *grb) {
+	uint8_t *pixel = &led_rgb_frame[id * LED_RGB_BYTES_PER_PIXEL];
+	
+	for (uint8_t i = 0; i < LED_RGB_BYTES_PER_PIXEL; i++) {
+		if (pixel[i] != grb[i]) {
+			pixel[i] = grb[i];
+			led_rgb_dirty = true;
+		}
+	}
+}
+
+
+
+/**
+ * @fn void leds_rgb_recolor(void)
+ * @brief Writes colors set by led_color() into pixels of LEDs that are on
+ * 
+ */
+static void leds_rgb_recolor(void) {
+	led_rgb_recolor = false;
+	
+	for (user_io_id_t id = 0; id < LEDS_AMOUNT; id++) {
+		if (led[id].output_on) {
+			led_rgb_write(id, led[id].color);
+		}
+	}
+}
+
+
+
+/**
+ * @fn void leds_rgb_flush(void)
+ * @brief Encodes frame buffer if a pixel changed this tick, sends it once last transfer completed
+ * 
+ */
+static void leds_rgb_flush(void) {
+	// Effects may have picked up a color half written, rewritten once led_color() is done
+	if (led_rgb_color_seq & 1U) {
+		return;
+	}
+	if (led_rgb_recolor) {
+		leds_rgb_recolor();
+	}
+	
+	// Back buffer isn't being sent, a frame still waiting there is replaced by the newer one
+	if (led_rgb_dirty) {
+		uint8_t *out = led_rgb_encoded[led_rgb_back];
+		
+		// Two color bits per lookup, MSB first
+		for (uint16_t i = 0; i < LED_RGB_FRAME_SIZE; i++) {
+			uint8_t byte = led_rgb_frame[i];
+			
+			*out++ = led_rgb_encode_lut[(byte >> 6) & 0x03];
+			*out++ = led_rgb_encode_lut[(byte >> 4) & 0x03];
+			*out++ = led_rgb_encode_lut[(byte >> 2) & 0x03];
+			*out++ = led_rgb_encode_lut[byte & 0x03];
+		}
+		
+		led_rgb_dirty = false;
+		led_rgb_pending = true;
+	}
+	
+	if (led_rgb_pending && !led_rgb_sending) {
+		led_rgb_pending = false;
+		led_rgb_sending = true;
+		led_driver_rgb_transfer(led_rgb_encoded[led_rgb_back], LED_RGB_ENCODED_SIZE);
+		led_rgb_back ^= 1;
+	}
+}
+
+
+
+/**
+ * @fn void led_rgb_transfer_done(void)
+ * @brief Releases buffer sent by led_driver_rgb_transfer(), next frame is sent on next tick
+ * 
+ * @note Call from transfer complete and error callbacks
+ */
+void led_rgb_transfer_done(void) {
+	led_rgb_sending = false;
+}
+#endif
+
+
+
+#ifdef USER_IO_EXPANDER_USE
+/**
+ * @fn bool expander_pin_read(uint8_t)
+ * @brief Returns level of expander pin from last read taken by handler, for btn_get_state() and switch_get_state()
+ * 
+ * @param pin (uint8_t) EXPANDER_PIN(port, bit)
+ * @return (bool) true if high
+ * 
+ * @note Doesn't touch the bus, inputs are read once per tick. Ports only change at start of a tick,
+ * never while the handler reads them
+ */
+bool expander_pin_read(uint8_t pin) {
+	return (expander_in[pin >> 3] >> (pin & 7U)) & 1U;
+}
+
+
+
+/**
+ * @fn uint8_t expander_port_read(uint8_t)
+ * @brief Returns levels of all pins on expander port from last read taken by handler
+ * 
+ * @param port (uint8_t) port
+ * @return (uint8_t) bit n is pin n
+ */
+uint8_t expander_port_read(uint8_t port) {
+	return expander_in[port];
+}
+
+
+
+/**
+ * @fn void expander_pin_write(uint8_t, bool)
+ * @brief Sets level of expander output pin, for led_driver_on() and led_driver_off()
+ * 
+ * @param pin (uint8_t) EXPANDER_PIN(port, bit)
+ * @param high (bool) level
+ * 
+ * @note Doesn't touch the bus, changed latches are written once per tick
+ */
+void expander_pin_write(uint8_t pin, bool high) {
+	uint8_t mask = (uint8_t) (1U << (pin & 7U));
+	
+	if (high) {
+		expander_out[pin >> 3] |= mask;
+	} else {
+		expander_out[pin >> 3] &= (uint8_t) ~mask;
+	}
+}
+
+
+
+/**
+ * @fn void expander_pin_toggle(uint8_t)
+ * @brief Toggles level of expander output pin, for led_driver_toggle()
+ * 
+ * @param pin (uint8_t) EXPANDER_PIN(port, bit)
+ */
+void expander_pin_toggle(uint8_t pin) {
+	expander_out[pin >> 3] ^= (uint8_t) (1U << (pin & 7U));
+}
+
+
+
+/**
+ * @fn void expander_transfer_done(bool)
+ * @brief Completes transfer started by expander_bus_read() or expander_bus_write() and starts next one
+ * 
+ * @param ok (bool) false if transfer failed
+ * 
+ * @note Call from bus transfer complete and error callbacks, at same or higher priority than the handler.
+ * A completed read is only flagged, the handler copies it at start of next tick. A failed
+ * transfer is counted and retried on next tick, not right away
+ */
+void expander_transfer_done(bool ok) {
+	uint8_t state = expander_state;
+	
+	if (state == EXPANDER_READING) {
+		if (ok) {
+			expander_rx_ready = true;
+		} else {
+			expander_read_due = true;
+		}
+		
+	} else if (state == EXPANDER_WRITING) {
+		if (ok) {
+			for (uint8_t port = expander_tx_first; port < (expander_tx_first + expander_tx_amount); port++) {
+				expander_latched[port] = expander_tx[port];
+			}
+		}
+	}
+	
+	expander_state = EXPANDER_IDLE;
+	
+	if (!ok) {
+		expander_error_count++;
+		return;
+	}
+	
+	// Read waits behind a write, it goes next so outputs changing every tick don't starve it
+	if ((state == EXPANDER_WRITING) && expander_read_due && !expander_rx_ready) {
+		expander_read_due = false;
+		expander_state = EXPANDER_READING;
+		expander_bus_read(EXPANDER_INPUT_REG, expander_rx, EXPANDER_PORTS);
+		return;
+	}
+	expander_kick();
+}
 
 
 
 /**
- * @fn void user_io_init(void)
- * @brief Inits used mcu-periphs and framework used
+ * @fn uint32_t expander_errors(void)
+ * @brief Returns amount of failed expander transfers
  * 
+ * @return (uint32_t)
  */
-void user_io_init(void) {
-#ifdef SWITCHES_USE
-	switch_pins_init();
-#endif
+uint32_t expander_errors(void) {
+	return expander_error_count;
+}
 
 
 
-#ifdef BTNS_USE
-	btn_pins_init();
-	btns_init();
-#endif
+/**
+ * @fn void expander_init(void)
+ * @brief Sets up expander and its port caches, before pin drivers use them
+ * 
+ * @note Latches are assumed to be 0 after expander reset
+ */
+static void expander_init(void) {
+	expander_state = EXPANDER_IDLE;
+	expander_read_due = false;
+	expander_rx_ready = false;
+	expander_error_count = 0;
 	
+	for (uint8_t port = 0; port < EXPANDER_PORTS; port++) {
+		expander_in[port] = EXPANDER_INPUT_IDLE;
+		expander_out[port] = 0;
+		expander_latched[port] = 0;
+	}
+	
+	expander_bus_init();
+}
 
 
-#ifdef LEDS_USE
-	led_pins_init();
-	leds_init();
-#endif
-
 
+/**
+ * @fn void expander_take(void)
+ * @brief Copies completed read into inputs used by pin drivers, called at start of tick
+ * 
+ * @note Transfer callback only sets expander_rx_ready, so it can't change inputs
+ * while buttons or switches are read
+ */
+static void expander_take(void) {
+	if (!expander_rx_ready) {
+		return;
+	}
 	
-#ifdef INTERVALS_USE
-	intervals_init();
-#endif
+	for (uint8_t port = 0; port < EXPANDER_PORTS; port++) {
+		expander_in[port] = expander_rx[port];
+	}
+	expander_rx_ready = false;
 }
 
 
 
 /**
- * @fn void user_io_irq_handler(void)
- * @brief Checks and updates states
+ * @fn void expander_update(void)
+ * @brief Requests one read of all input ports, after changed latches are written
  * 
- * @note Must be called with fixed interval 
+ * @note Inputs read now are used from next tick
  */
-void user_io_irq_handler(void) {
-#ifdef BTNS_USE
-	btns_handle_states();
-#endif
+static void expander_update(void) {
+	expander_read_due = true;
+	expander_kick();
+}
 
 
 
-#ifdef LEDS_USE
-	leds_handle_effects();
+/**
+ * @fn void expander_kick(void)
+ * @brief Starts next transfer if bus is idle, changed latches are written in one burst before inputs are read
+ * 
+ */
+static void expander_kick(void) {
+	if (expander_state != EXPANDER_IDLE) {
+		return;
+	}
+	
+	uint8_t first = EXPANDER_PORTS;
+	uint8_t last = 0;
+	
+	for (uint8_t port = 0; port < EXPANDER_PORTS; port++) {
+		if (expander_out[port] != expander_latched[port]) {
+			if (first == EXPANDER_PORTS) {
+				first = port;
+			}
+			last = port;
+		}
+	}
+	
+	// Unchanged latches between changed ones are rewritten, it's still one transfer
+	if (first < EXPANDER_PORTS) {
+		expander_tx_first = first;
+		expander_tx_amount = (uint8_t) (last - first + 1U);
+		for (uint8_t port = first; port <= last; port++) {
+			expander_tx[port] = expander_out[port];
+		}
+		
+		expander_state = EXPANDER_WRITING;
+		expander_bus_write((uint8_t) (EXPANDER_OUTPUT_REG + first), &expander_tx[first], expander_tx_amount);
+		
+	} else if (expander_read_due && !expander_rx_ready) {
+		expander_read_due = false;
+		expander_state = EXPANDER_READING;
+		expander_bus_read(EXPANDER_INPUT_REG, expander_rx, EXPANDER_PORTS);
+	}
+}
 #endif
 
 
-	
+
 #ifdef INTERVALS_USE
-	intervals_update();
+/**
+ * @fn bool interval_reached_ms(enum interval_id, uint32_t)
+ * @brief Checks to see if ms interval is reached since last check
+ * 
+ * @param id (enum interval_id) interval to check
+ * @param ms (uint32_t) run at ms interval
+ * @return (bool)
+ * 
+ * @note Wrap safe, checks may be up to ~49 days, 2^32 ms, apart.
+ * With INTERVALS_STAGGER_USE, a new ms restarts the interval at a new phase, keep ms fixed per interval.
+ * With INTERVALS_DRIFT_FREE_USE, deadline moves one period, late checks catch up one period per call
+ */
+bool interval_reached_ms(enum interval_id id, uint32_t ms) {
+#ifdef INTERVALS_STAGGER_USE
+	uint32_t period = (ms + USER_IO_HANDLER_PERIOD_MS - 1) / USER_IO_HANDLER_PERIOD_MS;
+	
+	// New period, pick a phase for it
+	if (period && (interval_period[id] != period)) {
+		interval_stagger(id, period);
+	}
+	
+	// Due every whole period of ticks, time past due is kept in ticks so phase doesn't drift
+	ms = period * USER_IO_HANDLER_PERIOD_MS;
+#endif
+	
+	uint32_t now = intervals_ms;
+	uint32_t elapsed = now - interval_start[id];
+	
+	if (elapsed < ms) {
+		return false;
+	}
+	
+#if defined(INTERVALS_DRIFT_FREE_USE)
+	interval_start[id] += ms;
+#elif defined(INTERVALS_STAGGER_USE)
+	// Keep time past due, interval stays at its phase
+	interval_start[id] = now - (ms? (elapsed % ms) : 0);
+#else
+	interval_start[id] = now;
 #endif
+	
+	return true;
 }
 
 
 
-#ifdef SWITCHES_USE
+#ifdef INTERVALS_DRIFT_FREE_USE
 /**
- * @fn bool switch_check(enum switch_id)
- * @brief Checks if switch is on
+ * @fn uint32_t interval_periods_ms(enum interval_id, uint32_t)
+ * @brief Returns how many whole ms periods ended since last check, deadline moves past all of them
  * 
- * @param id (enum switch_id)
- * @return (bool)
+ * @param id (enum interval_id) interval to check
+ * @param ms (uint32_t) run at ms interval, 0 never ends a period
+ * @return (uint32_t) periods to process, more than 1 if checks were late
+ * 
+ * @note Same deadline as interval_reached_ms(), use either per interval
  */
-bool switch_on(enum switch_id id) {
-	return switch_get_state(id);
+uint32_t interval_periods_ms(enum interval_id id, uint32_t ms) {
+	if (!ms) {
+		return 0;
+	}
+	
+	uint32_t periods = (intervals_ms - interval_start[id]) / ms;
+	
+	interval_start[id] += periods * ms;
+	
+	return periods;
 }
+#endif
 
 
 
+#ifdef USER_IO_OS_USE
 /**
- * @fn bool switch_off(enum switch_id)
- * @brief Checks if switch is off
+ * @fn void interval_wait(enum interval_id, uint32_t)
+ * @brief Blocks calling task until ms interval is reached since last check
  * 
- * @param id (enum switch_id)
- * @return (bool)
+ * @param id (enum interval_id) interval to wait for
+ * @param ms (uint32_t) run at ms interval
+ * 
+ * @note Same as polling interval_reached_ms(), one task may wait for an interval at a time
  */
-bool switch_off(enum switch_id id) {
-	return !switch_get_state(id);
+void interval_wait(enum interval_id id, uint32_t ms) {
+	user_io_os_clear(USER_IO_OS_INTERVAL_BIT(id));
+#ifdef INTERVALS_STAGGER_USE
+	interval_wait_ms[id] = ((ms + USER_IO_HANDLER_PERIOD_MS - 1) / USER_IO_HANDLER_PERIOD_MS) * USER_IO_HANDLER_PERIOD_MS;
+#else
+	interval_wait_ms[id] = ms;
+#endif
+	intervals_waiting[USER_IO_BIT_WORD(id)] |= USER_IO_BIT_MASK(id);
+	
+	while (!interval_reached_ms(id, ms)) {
+		user_io_os_wait(USER_IO_OS_INTERVAL_BIT(id), USER_IO_WAIT_FOREVER);
+	}
+	
+	intervals_waiting[USER_IO_BIT_WORD(id)] &= ~USER_IO_BIT_MASK(id);
+	interval_wait_ms[id] = 0;
 }
 #endif
 
 
 
-#ifdef BTNS_USE
 /**
- * @fn bool btn_hold(enum btn_id)
- * @brief Checks if button is held down more than threshold in milliseconds
- * 
- * @param id (enum btn_id)
- * @return (bool)
- * 
- * @note Always check for the longest hold duration first to avoid missing longer hold events.
+ * @fn void intervals_init(void)
+ * @brief Inits interval counters
  */
-bool btn_hold_ms(enum btn_id id, uint16_t ms) {
-	return (btn[id].hold_duration >= ms)? true : false;
+static void intervals_init(void) {
+	for (user_io_id_t id = 0; id < INTERVALS_AMOUNT; id++) {
+		interval_start[id] = intervals_ms;
+#ifdef INTERVALS_STAGGER_USE
+		interval_period[id] = 0;
+		interval_phase[id] = 0;
+#endif
+	}
 }
 
 
 
 /**
- * @fn bool btn_depressed(enum btn_id)
- * @brief Checks if button is depressed
+ * @fn void intervals_update(uint32_t)
+ * @brief Advances interval clock, cost doesn't depend on amount of intervals
  * 
- * @param id (enum btn_id)
- * @return (bool)
+ * @param ticks (uint32_t) ticks elapsed
  */
-bool btn_depressed(enum btn_id id) {
-	return !btn[id].hold_duration;
+static void intervals_update(uint32_t ticks) {
+#ifdef INTERVALS_STAGGER_USE
+	intervals_ticks += ticks;
+#endif
+	intervals_ms += ticks * USER_IO_HANDLER_PERIOD_MS;
+	
+#ifdef USER_IO_OS_USE
+	// Only signaled while a task waits for it
+	for (user_io_id_t word = 0; word < USER_IO_BITMAP_WORDS(INTERVALS_AMOUNT); word++) {
+		uint32_t waiting = intervals_waiting[word];
+		
+		while (waiting) {
+			user_io_id_t id = (user_io_id_t) ((word << 5) + USER_IO_CTZ(waiting));
+			
+			waiting &= waiting - 1;
+			if ((intervals_ms - interval_start[id]) >= interval_wait_ms[id]) {
+				user_io_os_fired |= USER_IO_OS_INTERVAL_BIT(id);
+			}
+		}
+	}
+#endif
 }
+#endif
 
 
 
+#ifdef INTERVALS_STAGGER_USE
 /**
- * @fn bool btn_released(enum btn_id)
- * @brief Checks if button is released
+ * @fn uint8_t intervals_max_due(void)
+ * @brief Returns worst case amount of intervals due in the same tick
  * 
- * @param id (enum btn_id)
- * @return (bool)
+ * @return (uint8_t)
+ * 
+ * @note Only intervals checked at least once are counted, since period is unknown before.
+ * Due ticks are scanned if they repeat within INTERVALS_STAGGER_SCAN_TICKS ticks, up to
+ * INTERVALS_STAGGER_SCAN_TICKS * INTERVALS_AMOUNT steps. Else the largest set of intervals
+ * pairwise sharing ticks is searched, exponential in intervals sharing ticks, call from main loop
  */
-bool btn_released(enum btn_id id) {
-	uint8_t temp = btn[id].released;
+uint8_t intervals_max_due(void) {
+	uint32_t repeat = 1;
+	uint8_t worst = 0;
+	
+	// Due ticks of all intervals repeat every lcm of periods
+	for (user_io_id_t id = 0; id < INTERVALS_AMOUNT; id++) {
+		uint32_t period = interval_period[id];
+		
+		if (!period) {
+			continue;
+		}
+		
+		uint32_t gcd = intervals_gcd(repeat, period);
+		
+		if ((repeat / gcd) > (INTERVALS_STAGGER_SCAN_TICKS / period)) {
+			return intervals_max_due_search();
+		}
+		repeat = (repeat / gcd) * period;
+	}
 	
-	// Reset state
-	btn[id].released = false;
+	for (uint32_t tick = 0; tick < repeat; tick++) {
+		uint8_t due = 0;
+		
+		for (user_io_id_t id = 0; id < INTERVALS_AMOUNT; id++) {
+			if (interval_period[id] && ((tick % interval_period[id]) == interval_phase[id])) {
+				due++;
+			}
+		}
+		
+		if (due > worst) {
+			worst = due;
+		}
+	}
 	
-	return temp;
+	return worst;
 }
 
 
 
 /**
- * @fn bool btn_click(enum btn_id)
- * @brief Checks if click is registered on specified button
+ * @fn void interval_stagger(enum interval_id, uint32_t)
+ * @brief Picks phase for interval sharing the fewest ticks with other intervals, spread as far from them as possible
  * 
- * @param id (enum btn_id)
- * @return (bool)
+ * @param id (enum interval_id) interval to place
+ * @param period (uint32_t) period in ticks
+ * 
+ * @note Counting restarts, interval is first due on next tick matching its phase.
+ * Tries up to INTERVALS_STAGGER_CANDIDATES phases against every other interval
  */
-bool btn_click(enum btn_id id) {
-	uint8_t temp = btn[id].click;
+static void interval_stagger(enum interval_id id, uint32_t period) {
+	uint32_t best_phase = 0;
+	uint32_t best_collisions = 0xFFFFFFFFU;
+	uint32_t best_distance = 0;
+	uint32_t step = (period + INTERVALS_STAGGER_CANDIDATES - 1) / INTERVALS_STAGGER_CANDIDATES;
+	
+	// Excluded while placing
+	interval_period[id] = 0;
+	
+	for (uint32_t phase = 0; phase < period; phase += step) {
+		uint32_t collisions = 0;
+		uint32_t distance = 0xFFFFFFFFU;
+		
+		for (user_io_id_t other = 0; other < INTERVALS_AMOUNT; other++) {
+			if ((other == id) || !interval_period[other]) {
+				continue;
+			}
+			
+			// Ticks both can be due on repeat every gcd of periods
+			uint32_t gcd = intervals_gcd(period, interval_period[other]);
+			uint32_t offset = ((phase % gcd) + gcd - (interval_phase[other] % gcd)) % gcd;
+			uint32_t other_distance = (offset < (gcd - offset))? offset : (gcd - offset);
+			
+			if (!offset) {
+				collisions++;
+			}
+			if (other_distance < distance) {
+				distance = other_distance;
+			}
+		}
+		
+		if ((collisions < best_collisions) || ((collisions == best_collisions) && (distance > best_distance))) {
+			best_phase = phase;
+			best_collisions = collisions;
+			best_distance = distance;
+		}
+	}
+	
+	uint32_t now = intervals_ticks;
+	uint32_t until_due = (best_phase + period - (now % period)) % period;
 	
-	// Reset state
-	btn[id].click = false;
+	interval_phase[id] = best_phase;
+	interval_period[id] = period;
 	
-	return temp;
+	// Count as if started one period before next tick matching phase
+	interval_start[id] = intervals_ms - ((period - (until_due? until_due : period)) * USER_IO_HANDLER_PERIOD_MS);
 }
 
 
 
 /**
- * @fn bool btns_no_input_ms(uint32_t)
- * @brief Checks for lack of input on all btns for more than idle_ms
+ * @fn bool interval_collides(enum interval_id, enum interval_id)
+ * @brief Checks if two intervals are ever due in the same tick
  * 
- * @param idle_ms (uint32_t) no input threshold
+ * @param id (enum interval_id)
+ * @param other (enum interval_id)
  * @return (bool)
  */
-bool btns_no_input_ms(uint32_t idle_ms) {
-	if (btns_idle_counter_ms > idle_ms) {
-		return true;
-	}
-	return false;
+static bool interval_collides(enum interval_id id, enum interval_id other) {
+	uint32_t gcd = intervals_gcd(interval_period[id], interval_period[other]);
+	
+	return (interval_phase[id] % gcd) == (interval_phase[other] % gcd);
 }
 
 
 
 /**
- * @fn void btns_init(void)
- * @brief Inits all buttons with default params
+ * @fn uint32_t intervals_gcd(uint32_t, uint32_t)
+ * @brief Returns greatest common divisor of two periods
  * 
+ * @param a (uint32_t)
+ * @param b (uint32_t)
+ * @return (uint32_t)
  */
-static void btns_init(void) {
-	for (uint8_t id = 0; id < BTNS_AMOUNT; id++) {
-		btn[id].id = id;
-		btn[id].curr_state = BTN_DEPRESSED;
-		btn[id].last_state = BTN_DEPRESSED;
-		btn[id].debounce_counter = 0;
-		btn[id].press_counter = 0;
-		btn[id].click = false;		
-		btn[id].hold_duration = 0;
-		btn[id].released = false;
+static uint32_t intervals_gcd(uint32_t a, uint32_t b) {
+	while (b) {
+		uint32_t r = a % b;
+		
+		a = b;
+		b = r;
 	}
+	
+	return a;
 }
 
 
 
 /**
- * @fn void btns_handle_states(void)
- * @brief Update btn states, check for click or hold etc
+ * @fn uint8_t intervals_max_due_search(void)
+ * @brief Returns size of largest set of intervals pairwise sharing ticks
  * 
+ * @return (uint8_t)
+ * 
+ * @note Intervals pairwise sharing ticks are all due in a common tick, by the chinese remainder theorem
  */
-static void btns_handle_states(void) {
-	if (btns_idle_counter_ms < BTNS_IDLE_MS_MAX) {
-		btns_idle_counter_ms += USER_IO_HANDLER_PERIOD_MS;
-	}
+static uint8_t intervals_max_due_search(void) {
+	uint32_t collides[INTERVALS_AMOUNT];
+	uint32_t known = 0;
 	
-	for (uint8_t id = 0; id < BTNS_AMOUNT; id++) {
-		btn_debounce(id);
+	for (user_io_id_t id = 0; id < INTERVALS_AMOUNT; id++) {
+		collides[id] = 0;
 		
-		// Check for click
-		if ((btn[id].curr_state == BTN_PRESSED) && (btn[id].last_state == BTN_DEPRESSED)) {
-			btn[id].click = true;
-			btns_idle_counter_ms = 0;
-			
-		// Check for hold 
-		} else if ((btn[id].curr_state == BTN_PRESSED) && (btn[id].last_state == BTN_PRESSED)) {
-			btn[id].hold_duration += USER_IO_HANDLER_PERIOD_MS;		
-			btns_idle_counter_ms = 0;
-			
-		// Check for release
-		} else if ((btn[id].curr_state == BTN_DEPRESSED) && (btn[id].last_state == BTN_PRESSED)) {
-			btn[id].released = true;
-			btn[id].hold_duration = 0;
+		if (!interval_period[id]) {
+			continue;
 		}
+		known |= (uint32_t) 1U << id;
 		
-
-		btn[id].last_state = btn[id].curr_state;
+		for (user_io_id_t other = 0; other < INTERVALS_AMOUNT; other++) {
+			if ((other != id) && interval_period[other] && interval_collides(id, other)) {
+				collides[id] |= (uint32_t) 1U << other;
+			}
+		}
 	}
+	
+	return intervals_max_due_from(known, collides, 0);
 }
 
 
 
 /**
- * @fn void btn_debounce(enum btn_id)
- * @brief Debounces specific button
+ * @fn uint8_t intervals_max_due_from(uint32_t, const uint32_t*, uint8_t)
+ * @brief Finds largest set of intervals that are all due in the same tick
  * 
- * @param id (enum btn_id) button to debounce
+ * @param candidates (uint32_t) intervals left to add, bit n is interval n
+ * @param collides (const uint32_t*) intervals each interval shares ticks with
+ * @param best (uint8_t) largest set found so far, sets that can't beat it aren't searched
+ * @return (uint8_t) size of largest set, at least best
  */
-static void btn_debounce(enum btn_id id) {
-	btn[id].press_counter += (uint8_t) btn_get_state(id);
-			
-	// Debounce btn
-	if (btn[id].debounce_counter >= BTN_DEBOUNCE_TRESHOLD) {
+static uint8_t intervals_max_due_from(uint32_t candidates, const uint32_t *collides, uint8_t best) {
+	uint8_t left = 0;
+	
+	for (uint32_t bits = candidates; bits; bits &= bits - 1) {
+		left++;
+	}
+	
+	// Each interval added leaves fewer candidates, stop once all left can't beat best
+	while (left > best) {
+		user_io_id_t id = (user_io_id_t) USER_IO_CTZ(candidates);
 		
-		// Register as press
-		if (btn[id].press_counter > 0) {
-			btn[id].curr_state = BTN_PRESSED;
-			btn[id].press_counter = 0;
-			
-		// Register as depressed, reset state
-		} else {
-			btn[id].curr_state = BTN_DEPRESSED;
-		}
+		candidates &= candidates - 1;
+		left--;
 		
-		btn[id].debounce_counter = 0;
-	} else {
-		btn[id].debounce_counter++;
+		uint8_t due = (uint8_t) (1 + intervals_max_due_from(candidates & collides[id], collides, best? (uint8_t) (best - 1) : 0));
+		if (due > best) {
+			best = due;
+		}
 	}
+	
+	return best;
 }
 #endif
 
 
 
-#ifdef LEDS_USE
+#ifdef ENCODERS_USE
 /**
- * @fn void led_blink_infinite(enum led_id, uint16_t)
- * @brief Applies infinite blinking effect to specified LED
+ * @fn void encoders_sample(void)
+ * @brief Samples and decodes all encoders
  * 
- * @param id (enum led_id) LED to apply effect to
- * @param blink_rate_ms (uint16_t) time in ms LED is on and off
+ * @note Called by handler unless ENCODERS_EXTERNAL_SAMPLE is defined, then call it from a faster timer.
+ * Must run at least once per quadrature step to not lose steps
  */
-void led_blink_infinite(enum led_id id, uint16_t blink_rate_ms) {
-	led[id].set_state = BLINK_INFINITE;
-	led[id].effect_rate = blink_rate_ms;
+void encoders_sample(void) {
+	for (user_io_id_t id = 0; id < ENCODERS_AMOUNT; id++) {
+		encoder[id].state = (uint8_t) (((encoder[id].state << 2) | encoder_get_ab(id)) & 0x0F);
+		encoder[id].steps += (uint32_t) (int32_t) encoder_decode_lut[encoder[id].state];
+	}
 }
 
 
 
 /**
- * @fn void led_blink_ms(enum led_id, uint16_t, uint16_t)
- * @brief Applies finite blinking effect to specified LED
+ * @fn int32_t encoder_read_delta(enum encoder_id, int16_t*)
+ * @brief Returns detents turned since last check
+ * 
+ * @param id (enum encoder_id) encoder to read
+ * @param velocity (int16_t*) detents per second, optional, pass 0 if not needed
+ * @return (int32_t) detents, positive when A leads B
  * 
- * @param id (enum led_id) LED to apply effect to
- * @param blink_rate_ms (uint16_t) time in ms LED is on and off
- * @param duration_ms (uint16_t) blinking effect time ms
+ * @note Steps not yet making up a full detent are kept for next check
  */
-void led_blink_ms(enum led_id id, uint16_t blink_rate_ms, uint16_t duration_ms) {
-	led[id].set_state = BLINK_MS;
-	led[id].effect_rate = blink_rate_ms;
-	led[id].effect_duration = (int16_t) duration_ms;
+int32_t encoder_read_delta(enum encoder_id id, int16_t *velocity) {
+	int32_t delta = (int32_t) (encoder[id].steps - encoder[id].read_steps) / ENCODER_STEPS_PER_DETENT;
+	
+	encoder[id].read_steps += (uint32_t) (delta * ENCODER_STEPS_PER_DETENT);
+	
+	if (velocity) {
+		*velocity = encoder[id].velocity;
+	}
+	
+	return delta;
 }
 
 
 
 /**
- * @fn void led_blink_n_times(enum led_id, uint16_t, uint16_t)
- * @brief Applies finite blinking effect to specified LED
+ * @fn void encoders_init(void)
+ * @brief Inits all encoders with current pin states
  * 
- * @param id (enum led_id) LED to apply effect to
- * @param blink_rate_ms (uint16_t) time in ms LED is on and off
- * @param n (uint16_t) how many times LED blinks
  */
-void led_blink_n_times(enum led_id id, uint16_t blink_rate_ms, uint16_t n) {
-	led[id].set_state = BLINK_N_TIMES;
-	led[id].effect_rate = blink_rate_ms;
-	led[id].effect_duration = (int16_t) (n<<1); // Double, because off and on counts as 1 time each 
+static void encoders_init(void) {
+	for (user_io_id_t id = 0; id < ENCODERS_AMOUNT; id++) {
+		encoder[id].id = id;
+		encoder[id].state = encoder_get_ab(id);
+		encoder[id].steps = 0;
+		encoder[id].read_steps = 0;
+		encoder[id].window_steps = 0;
+		encoder[id].window_counter = 0;
+		encoder[id].velocity = 0;
+	}
 }
 
 
 
 /**
- * @fn void led_off(enum led_id)
- * @brief Turns off specified LED
- * 
- * @param id (enum led_id) LED to turn off
+ * @fn void encoders_update_velocity(uint32_t)
+ * @brief Updates velocity of all encoders once every ENCODER_VELOCITY_WINDOW_MS
  * 
- * @note Only applies to LEDs that are on or blinking infinitely,
- * does not apply to finite effects. See led_force_off() for an alternative
+ * @param ticks (uint32_t) ticks elapsed
  */
-void led_off(enum led_id id) {
-	// Let effects with duration finish
-	if ((led[id].set_state == ON) || (led[id].set_state == BLINK_INFINITE)) {
-		led[id].set_state = OFF;
+static void encoders_update_velocity(uint32_t ticks) {
+	for (user_io_id_t id = 0; id < ENCODERS_AMOUNT; id++) {
+		uint32_t window_counter = encoder[id].window_counter + (ticks * USER_IO_HANDLER_PERIOD_MS);
 		
-		// Makes sure start of blink effect is the same
-		led[id].effect_counter = 0;
+		encoder[id].window_counter = (window_counter > 0xFFFFU)? 0xFFFFU : (uint16_t) window_counter;
+		
+		if (encoder[id].window_counter >= ENCODER_VELOCITY_WINDOW_MS) {
+			uint32_t steps = encoder[id].steps;
+			int32_t window_delta = (int32_t) (steps - encoder[id].window_steps);
+			
+			// Window may be longer if ticks were handled at once
+			encoder[id].velocity = (int16_t) ((window_delta * 1000) / ((int32_t) encoder[id].window_counter * ENCODER_STEPS_PER_DETENT));
+			encoder[id].window_steps = steps;
+			encoder[id].window_counter = 0;
+		}
 	}
 }
+#endif
 
 
 
+#ifdef TASKS_USE
 /**
- * @fn void led_force_off(enum led_id)
- * @brief Forces off specified LED no matter what effect is ongoing
+ * @fn void task_start(enum task_id, bool(*)(enum task_id))
+ * @brief Starts task from the beginning, it first runs on next tasks_run()
  * 
- * @param id (enum led_id) LED to turn off
+ * @param id (enum task_id) task
+ * @param fn (bool (*)(enum task_id)) task body, returns true when done
+ * 
+ * @note Body is written between TASK_BEGIN() and TASK_END(), locals must be static
+ * to keep their value across waits
  */
-void led_force_off(enum led_id id) {
-	led[id].set_state = OFF;
-	
-	// Makes sure start of blink effect is the same
-	led[id].effect_counter = 0;
+void task_start(enum task_id id, bool (*fn)(enum task_id id)) {
+	task[id].wait = TASK_WAITING_NONE;
+	task[id].running = true;
+	task_fn[id] = fn;
+	task[id].resume_point = 0;
+	task[id].ready = true;
+	tasks_ready = true;
 }
 
 
 
 /**
- * @fn void led_on(enum led_id)
- * @brief Turns on specified LED
+ * @fn void task_stop(enum task_id)
+ * @brief Stops task, it doesn't resume anymore
  * 
- * @param id (enum led_id) LED to turn on
+ * @param id (enum task_id) task
  */
-void led_on(enum led_id id) {
-	led[id].set_state = ON;
+void task_stop(enum task_id id) {
+	task[id].wait = TASK_WAITING_NONE;
+	task[id].ready = false;
+	task[id].running = false;
+	task_fn[id] = 0;
 }
 
 
 
+#ifdef USER_IO_RETAIN_USE
 /**
- * @fn void led_pulse(enum led_id, uint16_t)
- * @brief Pulse LED
+ * @fn void task_attach(enum task_id, bool(*)(enum task_id))
+ * @brief Sets body of task restored by user_io_resume(), it continues at the line it waited on
  * 
- * @param id (enum led_id) LED to pulse
- * @param pulse_duration_ms (uint16_t) how long LED is on ms
+ * @param id (enum task_id) task
+ * @param fn (bool (*)(enum task_id)) task body, same as passed to task_start()
+ * 
+ * @note Bodies aren't retained, restored tasks don't run until attached. Does nothing if task isn't running
  */
-void led_pulse(enum led_id id, uint16_t pulse_duration_ms) {
-	led[id].set_state = PULSE;
-	led[id].effect_duration = (int16_t) pulse_duration_ms;
+void task_attach(enum task_id id, bool (*fn)(enum task_id id)) {
+	if (!task[id].running) {
+		return;
+	}
+	task_fn[id] = fn;
+	tasks_ready = true;
 }
+#endif
 
 
 
 /**
- * @fn void led_all_off(void)
- * @brief Turn all LEDs off
+ * @fn bool task_running(enum task_id)
+ * @brief Checks if task is started and not done
  * 
- * @note Only applies to LEDs that are on or blinking infinitely,
- * does not apply to finite effects. See led_all_force_off() for an alternative
+ * @param id (enum task_id) task
+ * @return (bool)
  */
-void led_all_off(void) {
-	for (uint8_t id = 0; id < LEDS_AMOUNT; id++) {
-		led_off(id);
-	}
+bool task_running(enum task_id id) {
+	return task[id].running;
 }
 
 
 
 /**
- * @fn void led_all_force_off(void)
- * @brief Forces all LEDs off no matter what effect is ongoing
+ * @fn void tasks_run(void)
+ * @brief Resumes tasks whose wait ended, call from main loop
  * 
+ * @note Returns at once if no wait ended since last call
  */
-void led_all_force_off(void) {
-	for (uint8_t id = 0; id < LEDS_AMOUNT; id++) {
-		led_force_off(id);
+void tasks_run(void) {
+	if (!tasks_ready) {
+		return;
+	}
+	tasks_ready = false;
+	
+	for (user_io_id_t id = 0; id < TASKS_AMOUNT; id++) {
+		// Restored but not attached yet, wake is kept
+		if (!task[id].ready || !task_fn[id]) {
+			continue;
+		}
+		task[id].ready = false;
+		
+#ifdef BTNS_USE
+		if (task[id].wait == TASK_CLICKED) {
+			task[id].wait = TASK_WAITING_NONE;
+			btn_event_take(&btns_click, (enum btn_id) task[id].wait_arg);
+		}
+#endif
+		
+		// Done, task stops
+		if (task_fn[id](id)) {
+			task[id].running = false;
+			task_fn[id] = 0;
+		}
 	}
 }
 
 
 
 /**
- * @fn void led_all_on(void)
- * @brief Turn all LEDs on
+ * @fn uint16_t task_resume_point(enum task_id)
+ * @brief Returns line task waited on, 0 when started
  * 
+ * @param id (enum task_id) task
+ * @return (uint16_t)
  */
-void led_all_on(void) {
-	for (uint8_t id = 0; id < LEDS_AMOUNT; id++) {
-		led_on(id);
-	}
+uint16_t task_resume_point(enum task_id id) {
+	return task[id].resume_point;
 }
 
 
 
 /**
- * @fn void led_all_blink_infinite(uint16_t)
- * @brief Apply infinite blinking effect to all LEDs
+ * @fn void task_yield(enum task_id, uint16_t)
+ * @brief Lets other tasks run, task resumes on next tasks_run()
  * 
- * @param blink_rate_ms (uint16_t) time in ms LEDs are on and off
+ * @param id (enum task_id) task
+ * @param line (uint16_t) line to resume at
  */
-void led_all_blink_infinite(uint16_t blink_rate_ms) {
-	for (uint8_t id = 0; id < LEDS_AMOUNT; id++) {
-		led_blink_infinite(id, blink_rate_ms);
-	}
+void task_yield(enum task_id id, uint16_t line) {
+	task[id].resume_point = line;
+	task[id].ready = true;
+	tasks_ready = true;
 }
 
 
 
 /**
- * @fn void led_all_blink_n_times(uint16_t, uint16_t)
- * @brief Apply finite blinking effect to all LEDs
+ * @fn void task_wait_ms(enum task_id, uint32_t, uint16_t)
+ * @brief Resumes task once ms has passed
  * 
- * @param blink_rate_ms (uint16_t) time in ms LEDs are on and off
- * @param n (uint16_t) how many times LEDs blink
+ * @param id (enum task_id) task
+ * @param ms (uint32_t) time to wait
+ * @param line (uint16_t) line to resume at
  */
-void led_all_blink_n_times(uint16_t blink_rate_ms, uint16_t n) {
-	for (uint8_t id = 0; id < LEDS_AMOUNT; id++) {
-		led_blink_n_times(id, blink_rate_ms, n);
-	}
+void task_wait_ms(enum task_id id, uint32_t ms, uint16_t line) {
+	task[id].resume_point = line;
+	task[id].wait_ms = ms;
+	
+	// Set last, handler checks wait from now on
+	task[id].wait = TASK_WAITING_MS;
 }
 
 
 
+#ifdef BTNS_USE
 /**
- * @fn void led_all_blink_ms(uint16_t, uint16_t)
- * @brief Apply finite blinking effect to all LEDs
+ * @fn void task_wait_click(enum task_id, enum btn_id, uint16_t)
+ * @brief Resumes task on next click of button, the click is consumed
  * 
- * @param blink_rate_ms (uint16_t) time in ms LEDs are on and off
- * @param duration_ms (uint16_t) blinking effect time ms
+ * @param id (enum task_id) task
+ * @param btn_id (enum btn_id) button to wait for
+ * @param line (uint16_t) line to resume at
+ * 
+ * @note Clicks registered before waiting are discarded. The click is taken when the task resumes,
+ * btn_click() on same button in between sees it too
  */
-void led_all_blink_ms(uint16_t blink_rate_ms, uint16_t duration_ms) {
-	for (uint8_t id = 0; id < LEDS_AMOUNT; id++) {
-		led_blink_ms(id, blink_rate_ms, duration_ms);
-	}
+void task_wait_click(enum task_id id, enum btn_id btn_id, uint16_t line) {
+	task[id].resume_point = line;
+	task[id].wait_arg = (user_io_id_t) btn_id;
+	btn_event_take(&btns_click, btn_id);
+	
+	// Set last, handler checks wait from now on
+	task[id].wait = TASK_WAITING_CLICK;
 }
+#endif
 
 
 
+#if defined(LEDS_USE) && !defined(LED_WAVEFORM_USE)
 /**
- * @fn void led_all_pulse(uint16_t)
- * @brief Pulse all LEDs
+ * @fn void task_wait_led_done(enum task_id, enum led_id, uint16_t)
+ * @brief Resumes task once finite effect on LED is done
  * 
- * @param pulse_duration_ms (uint16_t) how long LEDs are on ms
+ * @param id (enum task_id) task
+ * @param led_id (enum led_id) LED to wait for
+ * @param line (uint16_t) line to resume at
+ * 
+ * @note Blink ms, blink n times and pulse are finite, other effects count as done
  */
-void led_all_pulse(uint16_t pulse_duration_ms) {
-	for (uint8_t id = 0; id < LEDS_AMOUNT; id++) {
-		led_pulse(id, pulse_duration_ms);
-	}
+void task_wait_led_done(enum task_id id, enum led_id led_id, uint16_t line) {
+	task[id].resume_point = line;
+	task[id].wait_arg = (user_io_id_t) led_id;
+	
+	// Set last, handler checks wait from now on
+	task[id].wait = TASK_WAITING_LED_DONE;
 }
+#endif
 
 
 
 /**
- * @fn void leds_init(void)
- * @brief Inits all LEDs with default params
+ * @fn void tasks_init(void)
+ * @brief Inits all tasks as stopped
  * 
  */
-static void leds_init(void) {
-	for (uint8_t id = 0; id < LEDS_AMOUNT; id++) {
-		led[id].id = id;
-		led[id].set_state = OFF;
-		led[id].curr_state = OFF;
-		led[id].effect_counter = 0;
-		led[id].effect_rate = 0;	
-		led[id].effect_duration = 0;
+static void tasks_init(void) {
+	for (user_io_id_t id = 0; id < TASKS_AMOUNT; id++) {
+		task[id].id = id;
+		task[id].running = false;
+		task_fn[id] = 0;
+		task[id].wait_ms = 0;
+		task[id].resume_point = 0;
+		task[id].wait_arg = 0;
+		task[id].wait = TASK_WAITING_NONE;
+		task[id].ready = false;
 	}
 }
 
 
 
 /**
- * @fn void leds_handle_effects(void)
- * @brief Apply effects and animate them for all LEDs
+ * @fn void tasks_update(uint32_t)
+ * @brief Checks wait conditions of all waiting tasks, marks them ready when met
  * 
+ * @param ticks (uint32_t) ticks elapsed
  */
-static void leds_handle_effects(void) {
-	for (uint8_t id = 0; id < LEDS_AMOUNT; id++) {
-		switch (led[id].set_state) {
+static void tasks_update(uint32_t ticks) {
+	for (user_io_id_t id = 0; id < TASKS_AMOUNT; id++) {
+		switch (task[id].wait) {
 		
-			case BLINK_INFINITE:
-				led_handle_effect_blink_infinite(id);
-				break;				
-				
-			case BLINK_MS:
-				led_handle_effect_blink_ms(id);
+			case TASK_WAITING_MS:
+				if (task[id].wait_ms <= (ticks * USER_IO_HANDLER_PERIOD_MS)) {
+					task_wake(id);
+				} else {
+					task[id].wait_ms -= ticks * USER_IO_HANDLER_PERIOD_MS;
+				}
 				break;
-						
-			case BLINK_N_TIMES:
-				led_handle_effect_blink_n_times(id);
-				break;
-												
-			case OFF:
-				led_handle_effect_off(id);
+				
+#ifdef BTNS_USE
+			case TASK_WAITING_CLICK:
+				// Only main loop takes events, tasks_run() takes this one
+				if (btn_events_pending(&btns_click, USER_IO_BIT_WORD(task[id].wait_arg)) & USER_IO_BIT_MASK(task[id].wait_arg)) {
+					task[id].wait = TASK_CLICKED;
+					task[id].ready = true;
+					tasks_ready = true;
+				}
 				break;
-											
-			case PULSE:
-				led_handle_effect_pulse(id);
+#endif
+
+#if defined(LEDS_USE) && !defined(LED_WAVEFORM_USE)
+			case TASK_WAITING_LED_DONE:
+				if ((led[task[id].wait_arg].set_state != BLINK_MS)
+						&& (led[task[id].wait_arg].set_state != BLINK_N_TIMES)
+						&& (led[task[id].wait_arg].set_state != PULSE)) {
+					task_wake(id);
+				}
 				break;
+#endif
 				
-			case ON:
-				led_handle_effect_on(id);
+			default:
 				break;
 		}
 	}
@@ -678,195 +5602,182 @@ static void leds_handle_effects(void) {
 
 
 /**
- * @fn void led_effect_blink_infinite(enum led_id)
- * @brief Handles blink infinite effect
+ * @fn void task_wake(enum task_id)
+ * @brief Ends wait of task, it resumes on next tasks_run()
  * 
- * @param id (enum led_id) LED
+ * @param id (enum task_id) task
  */
-static void led_handle_effect_blink_infinite(enum led_id id) {
-	// Time to toggle
-	if (led[id].effect_counter <= 0) {
-		led_driver_toggle(id);
-		led[id].curr_state = BLINK_INFINITE;
-		
-		// Reset counter
-		led[id].effect_counter = (int16_t) led[id].effect_rate;
-	}
-	
-	// Remaining time to toggle
-	led[id].effect_counter -= USER_IO_HANDLER_PERIOD_MS;
+static void task_wake(enum task_id id) {
+	task[id].wait = TASK_WAITING_NONE;
+	task[id].ready = true;
+	tasks_ready = true;
 }
+#endif
 
 
 
+#ifdef BINDINGS_USE
 /**
- * @fn void led_handle_effect_blink_ms(enum led_id)
- * @brief Handles blink ms effect
+ * @fn void binding_set(uint8_t, enum binding_source, uint16_t, enum led_id, enum binding_effect, uint16_t)
+ * @brief Sets rule that drives LED from button or switch inside the handler
  * 
- * @param id (enum led_id) LED
+ * @param slot (uint8_t) rule slot, less than BINDINGS_AMOUNT
+ * @param source (enum binding_source) event or state that triggers effect
+ * @param input (uint16_t) enum btn_id or enum switch_id, depending on source
+ * @param led_id (enum led_id) LED to drive
+ * @param effect (enum binding_effect) effect to start
+ * @param arg_ms (uint16_t) pulse duration or blink rate ms
+ * 
+ * @note Click and release start effect once. Held and switch states start it while active and
+ * turn LED off when inactive, BINDING_LED_OFF turns it back on
  */
-static void led_handle_effect_blink_ms(enum led_id id) {
-	// Effect is done
-	if (led[id].effect_duration <= 0) {
-		led_driver_off(id);
-		
-		led[id].set_state = OFF;
-		led[id].curr_state = OFF;
-		return;
-	}
+void binding_set(uint8_t slot, enum binding_source source, uint16_t input, enum led_id led_id, enum binding_effect effect, uint16_t arg_ms) {
+	// Disable slot while it is rewritten
+	binding[slot].source = BINDING_NONE;
 	
-	// Calc remaining effect time
-	led[id].effect_duration -= USER_IO_HANDLER_PERIOD_MS;
+	binding[slot].input = input;
+	binding[slot].led_id = led_id;
+	binding[slot].effect = effect;
+	binding[slot].arg_ms = arg_ms;
+	binding_was_active[slot] = false;
 	
-	// Time to toggle
-	if (led[id].effect_counter <= 0) {
-		led_driver_toggle(id);
-		led[id].curr_state = BLINK_MS;
+	// Edges present before rule was set don't fire
+	if ((source == BINDING_BTN_CLICK) || (source == BINDING_BTN_RELEASE)) {
+		struct binding rule = binding[slot];
 		
-		// Reset counter
-		led[id].effect_counter = (int16_t) led[id].effect_rate;
+		rule.source = source;
+		binding_was_active[slot] = binding_active(&rule);
 	}
 	
-	// Remaining time to toggle
-	led[id].effect_counter -= USER_IO_HANDLER_PERIOD_MS;
+	binding[slot].source = source;
 }
 
 
 
 /**
- * @fn void led_handle_effect_blink_n_times(enum led_id)
- * @brief Handles blink n times effect
+ * @fn void binding_clear(uint8_t)
+ * @brief Removes rule, LED keeps its current effect
  * 
- * @param id (enum led_id) LED
+ * @param slot (uint8_t) rule slot
  */
-static void led_handle_effect_blink_n_times(enum led_id id) {
-	// N times reached
-	if (led[id].effect_duration <= 0) {
-		led_driver_off(id);
-		
-		led[id].set_state = OFF;
-		led[id].curr_state = OFF;
-		return;
-	}
-	
-	// Time to toggle
-	if (led[id].effect_counter <= 0) {
-		led_driver_toggle(id);
-		led[id].curr_state = BLINK_N_TIMES;
-		
-		// Reset counter
-		led[id].effect_counter = (int16_t) led[id].effect_rate;
-
-		// Update total blinks left
-		led[id].effect_duration--;
-	}
-	
-	// Remaining time to toggle
-	led[id].effect_counter -= USER_IO_HANDLER_PERIOD_MS;
+void binding_clear(uint8_t slot) {
+	binding[slot].source = BINDING_NONE;
 }
 
 
 
 /**
- * @fn void led_handle_effect_off(enum led_id)
- * @brief Handles off effect
+ * @fn void bindings_init(void)
+ * @brief Init rules, edges present at init don't fire
  * 
- * @param id (enum led_id) LED
  */
-static void led_handle_effect_off(enum led_id id) {
-	if (led[id].curr_state != OFF) {
-		led_driver_off(id);	
-		led[id].curr_state = OFF;
-	} 
+static void bindings_init(void) {
+	for (uint8_t slot = 0; slot < BINDINGS_AMOUNT; slot++) {
+		enum binding_source source = binding[slot].source;
+		
+		binding_was_active[slot] = ((source == BINDING_BTN_CLICK) || (source == BINDING_BTN_RELEASE))? binding_active(&binding[slot]) : false;
+	}
 }
 
 
 
 /**
- * @fn void led_handle_effect_pulse(enum led_id)
- * @brief Handles pulse effect
+ * @fn void bindings_update(void)
+ * @brief Starts LED effects of rules whose source changed, called after inputs are debounced
  * 
- * @param id (enum led_id) LED
+ * @note Elapsed handler checks only final states, edges within elapsed ticks are not seen
  */
-static void led_handle_effect_pulse(enum led_id id) {
-	// Pulse effect done
-	if (led[id].effect_duration <= 0) {
-		led_driver_off(id);
-		
-		led[id].set_state = OFF;
-		led[id].curr_state = OFF;
-		return;
+static void bindings_update(void) {
+	for (uint8_t slot = 0; slot < BINDINGS_AMOUNT; slot++) {
+		if (binding[slot].source == BINDING_NONE) {
+			continue;
+		}
 		
-	// Start pulse effect
-	} else if (led[id].curr_state != PULSE) {
-		led_driver_on(id);
+		bool active = binding_active(&binding[slot]);
 		
-		led[id].curr_state = PULSE;
+		if (active != binding_was_active[slot]) {
+			binding_was_active[slot] = active;
+			binding_apply(&binding[slot], active);
+		}
 	}
-		
-	// Remaining effect time
-	led[id].effect_duration -= USER_IO_HANDLER_PERIOD_MS;	
 }
 
 
 
 /**
- * @fn void led_handle_effect_on(enum led_id)
- * @brief Handles on effect
+ * @fn bool binding_active(const struct binding*)
+ * @brief Checks if rule source is active, click and held are active while pressed, release while depressed
  * 
- * @param id (enum led_id) LED
+ * @param rule (const struct binding*) rule to check
+ * @return (bool)
  */
-static void led_handle_effect_on(enum led_id id) {
-	if (led[id].curr_state != ON) {
-		led_driver_on(id);
-		led[id].curr_state = ON;
-	}
-}
+static bool binding_active(const struct binding *rule) {
+	switch (rule->source) {
+#ifdef BTNS_USE
+		case BINDING_BTN_CLICK:
+		case BINDING_BTN_HELD:
+			return btn[rule->input].curr_state == BTN_PRESSED;
+			
+		case BINDING_BTN_RELEASE:
+			return btn[rule->input].curr_state == BTN_DEPRESSED;
 #endif
 
+#ifdef SWITCHES_USE
+		case BINDING_SWITCH_ON:
+			return switch_get_state(rule->input) == SWITCH_ON;
+			
+		case BINDING_SWITCH_OFF:
+			return switch_get_state(rule->input) == SWITCH_OFF;
+#endif
 
-
-#ifdef INTERVALS_USE
-/**
- * @fn bool interval_reached_ms(enum interval_id, uint32_t)
- * @brief Checks to see if ms interval is reached since last check
- * 
- * @param id (enum interval_id) interval to check
- * @param ms (uint32_t) run at ms interval
- * @return (bool)
- * 
- * @note Can count up to ~49 days, 2^32 ms, before overflow
- */
-bool interval_reached_ms(enum interval_id id, uint32_t ms) {
-	if (interval[id] >= ms) {
-		interval[id] = 0;
-		
-		return true;
+		default:
+			return false;
 	}
-	return false;
 }
 
 
 
 /**
- * @fn void intervals_init(void)
- * @brief Inits interval counters
+ * @fn void binding_apply(const struct binding*, bool)
+ * @brief Starts rule effect when source becomes active, undoes state rules when it becomes inactive
+ * 
+ * @param rule (const struct binding*) rule whose source changed
+ * @param active (bool) new source state
  */
-static void intervals_init(void) {
-	for (uint8_t id = 0; id < INTERVALS_AMOUNT; id++) {
-		interval[id] = 0;
+static void binding_apply(const struct binding *rule, bool active) {
+	bool edge = (rule->source == BINDING_BTN_CLICK) || (rule->source == BINDING_BTN_RELEASE);
+	
+	// Edge rules fire once per activation
+	if (!active) {
+		if (!edge) {
+			if (rule->effect == BINDING_LED_OFF) {
+				led_set(LED_REQ_ON, rule->led_id, 0, 0);
+			} else {
+				led_set(LED_REQ_OFF, rule->led_id, 0, 0);
+			}
+		}
+		return;
 	}
-}
-
-
-
-/**
- * @fn void intervals_update(void)
- * @brief Updates counters for all intervals
- */
-static void intervals_update(void) {
-	for (uint8_t id = 0; id < INTERVALS_AMOUNT; id++) {
-		interval[id] += USER_IO_HANDLER_PERIOD_MS;
+	
+	switch (rule->effect) {
+		case BINDING_LED_ON:
+			led_set(LED_REQ_ON, rule->led_id, 0, 0);
+			break;
+			
+		case BINDING_LED_OFF:
+			led_set(LED_REQ_OFF, rule->led_id, 0, 0);
+			break;
+			
+		case BINDING_LED_PULSE:
+			led_set(LED_REQ_PULSE, rule->led_id, rule->arg_ms, 0);
+			break;
+			
+		case BINDING_LED_BLINK:
+			led_set(LED_REQ_BLINK_INFINITE, rule->led_id, rule->arg_ms, 0);
+			break;
+			
+		default:
+			break;
 	}
 }
 #endif
\ No newline at end of file
@@ -19,14 +19,305 @@
 //---------------------------//
 // Include begin
 //---------------------------//
+// clock_gettime() and pthread_condattr_setclock() of pthread backend, before any include
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "user_io_driver.h"
+
+#ifdef USER_IO_EXPANDER_USE
+#include "user_io.h"
+#endif
+
+#if defined(USER_IO_OS_USE) && defined(USER_IO_OS_FREERTOS)
+#include "FreeRTOS.h"
+#include "event_groups.h"
+#elif defined(USER_IO_OS_USE) && defined(USER_IO_OS_PTHREAD)
+#include <pthread.h>
+#include <time.h>
+#endif
 //---------------------------//
 // Include end
 //---------------------------//
 
 
 
-#ifdef SWITCHES_USE
+//---------------------------//
+// Variable begin
+//---------------------------//
+#if defined(USER_IO_OS_USE) && defined(USER_IO_OS_FREERTOS)
+static EventGroupHandle_t user_io_os_events;
+#elif defined(USER_IO_OS_USE) && defined(USER_IO_OS_PTHREAD)
+static pthread_mutex_t user_io_os_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t user_io_os_cond;
+static bool user_io_os_cond_ready = false;
+static uint32_t user_io_os_bits = 0;
+#endif
+
+#if defined(LED_MATRIX_USE) && defined(LED_MATRIX_CHARLIEPLEX)
+static const uint8_t led_matrix_pins[LED_MATRIX_ROWS] = {LED_MATRIX_PIN0, LED_MATRIX_PIN1};	// <-- EDIT HERE
+static uint32_t led_matrix_outputs = 0; // Bit n set while led_matrix_pins[n] is configured as output
+#elif defined(LED_MATRIX_USE)
+static const uint8_t led_matrix_row_pins[LED_MATRIX_ROWS] = {LED_ROW0_PIN, LED_ROW1_PIN};	// <-- EDIT HERE
+static const uint8_t led_matrix_col_pins[LED_MATRIX_COLS] = {LED_COL0_PIN, LED_COL1_PIN};	// <-- EDIT HERE
+#endif
+//---------------------------//
+// Variable end
+//---------------------------//
+
+
+
+#ifdef USER_IO_OS_USE
+#if defined(USER_IO_OS_FREERTOS)
+/**
+ * @fn void user_io_os_init(void)
+ * @brief Creates event flags used to wake waiting tasks
+ * 
+ */
+void user_io_os_init(void) {
+	user_io_os_events = xEventGroupCreate();
+}
+
+
+
+/**
+ * @fn uint32_t user_io_os_wait(uint32_t, uint32_t)
+ * @brief Blocks calling task until any of bits is signaled, clears them
+ * 
+ * @param bits (uint32_t) event bits to wait for
+ * @param timeout_ms (uint32_t) max time to block, USER_IO_WAIT_FOREVER to not time out
+ * @return (uint32_t) bits signaled, 0 if timed out
+ */
+uint32_t user_io_os_wait(uint32_t bits, uint32_t timeout_ms) {
+	TickType_t ticks = (timeout_ms == USER_IO_WAIT_FOREVER)? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+	
+	return (uint32_t) xEventGroupWaitBits(user_io_os_events, (EventBits_t) bits, pdTRUE, pdFALSE, ticks) & bits;
+}
+
+
+
+/**
+ * @fn void user_io_os_clear(uint32_t)
+ * @brief Clears stale event bits before waiting
+ * 
+ * @param bits (uint32_t) event bits to clear
+ */
+void user_io_os_clear(uint32_t bits) {
+	xEventGroupClearBits(user_io_os_events, (EventBits_t) bits);
+}
+
+
+
+/**
+ * @fn void user_io_os_signal(uint32_t)
+ * @brief Wakes tasks waiting for bits, called from handler
+ * 
+ * @param bits (uint32_t) event bits to signal
+ * 
+ * @note Event groups hold up to 24 bits, one per button and interval
+ */
+void user_io_os_signal(uint32_t bits) {
+#ifdef ALTERNATIVE_IRQ_METHOD
+	xEventGroupSetBits(user_io_os_events, (EventBits_t) bits);
+#else
+	BaseType_t woken = pdFALSE;
+	
+	xEventGroupSetBitsFromISR(user_io_os_events, (EventBits_t) bits, &woken);
+	portYIELD_FROM_ISR(woken);
+#endif
+}
+
+
+
+#elif defined(USER_IO_OS_PTHREAD)
+/**
+ * @fn void user_io_os_init(void)
+ * @brief Resets event flags used to wake waiting threads
+ * 
+ * @note Condition variable is created once on first call, it times out on CLOCK_MONOTONIC
+ * so wall clock changes don't stretch or cut timeouts
+ */
+void user_io_os_init(void) {
+	pthread_mutex_lock(&user_io_os_mutex);
+	if (!user_io_os_cond_ready) {
+		pthread_condattr_t attr;
+		
+		pthread_condattr_init(&attr);
+		pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+		pthread_cond_init(&user_io_os_cond, &attr);
+		pthread_condattr_destroy(&attr);
+		user_io_os_cond_ready = true;
+	}
+	user_io_os_bits = 0;
+	pthread_mutex_unlock(&user_io_os_mutex);
+}
+
+
+
+/**
+ * @fn uint32_t user_io_os_wait(uint32_t, uint32_t)
+ * @brief Blocks calling thread until any of bits is signaled, clears them
+ * 
+ * @param bits (uint32_t) event bits to wait for
+ * @param timeout_ms (uint32_t) max time to block, USER_IO_WAIT_FOREVER to not time out
+ * @return (uint32_t) bits signaled, 0 if timed out
+ */
+uint32_t user_io_os_wait(uint32_t bits, uint32_t timeout_ms) {
+	struct timespec deadline;
+	int err = 0;
+	
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += (time_t) (timeout_ms / 1000U);
+	deadline.tv_nsec += (long) (timeout_ms % 1000U) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+	
+	pthread_mutex_lock(&user_io_os_mutex);
+	
+	while (!(user_io_os_bits & bits) && !err) {
+		if (timeout_ms == USER_IO_WAIT_FOREVER) {
+			pthread_cond_wait(&user_io_os_cond, &user_io_os_mutex);
+		} else {
+			err = pthread_cond_timedwait(&user_io_os_cond, &user_io_os_mutex, &deadline);
+		}
+	}
+	
+	uint32_t signaled = user_io_os_bits & bits;
+	user_io_os_bits &= ~signaled;
+	
+	pthread_mutex_unlock(&user_io_os_mutex);
+	
+	return signaled;
+}
+
+
+
+/**
+ * @fn void user_io_os_clear(uint32_t)
+ * @brief Clears stale event bits before waiting
+ * 
+ * @param bits (uint32_t) event bits to clear
+ */
+void user_io_os_clear(uint32_t bits) {
+	pthread_mutex_lock(&user_io_os_mutex);
+	user_io_os_bits &= ~bits;
+	pthread_mutex_unlock(&user_io_os_mutex);
+}
+
+
+
+/**
+ * @fn void user_io_os_signal(uint32_t)
+ * @brief Wakes threads waiting for bits, called from handler thread
+ * 
+ * @param bits (uint32_t) event bits to signal
+ */
+void user_io_os_signal(uint32_t bits) {
+	pthread_mutex_lock(&user_io_os_mutex);
+	user_io_os_bits |= bits;
+	pthread_cond_broadcast(&user_io_os_cond);
+	pthread_mutex_unlock(&user_io_os_mutex);
+}
+#endif
+#endif
+
+
+
+// Pin drivers, replaced by user_io_driver_linux.c in Linux builds
+#ifndef USER_IO_LINUX_USE
+#if defined(USER_IO_OVERRUN_USE) || defined(BTN_TIMESTAMPS_USE)
+/**
+ * @fn uint32_t user_io_timestamp_us(void)
+ * @brief Returns free running timestamp in us, used to measure the handler and button edges
+ * 
+ * @return (uint32_t)
+ * 
+ * @note May wrap around, only differences are used. A cycle counter divided by core clock in MHz works
+ */
+uint32_t user_io_timestamp_us(void) {
+	return TIMESTAMP_US();	// <-- EDIT HERE
+}
+#endif
+
+
+
+#ifdef USER_IO_RETAIN_USE
+/**
+ * @fn void user_io_pins_resume(void)
+ * @brief Re-enables peripherals that lose their setup in sleep, called by user_io_resume()
+ * 
+ * @note Pins are expected to keep their configuration, only restart what sleep turned off
+ */
+void user_io_pins_resume(void) {
+#ifdef BTN_LADDER_USE
+	btn_ladder_adc_init();	// <-- EDIT HERE
+#endif
+#ifdef USER_IO_EXPANDER_USE
+	expander_bus_init();	// <-- EDIT HERE
+#endif
+}
+#endif
+
+
+
+#ifdef USER_IO_EXPANDER_USE
+/**
+ * @fn void expander_bus_init(void)
+ * @brief Sets expander pin directions and pull-ups, blocking transfers are fine here
+ * 
+ * @note Port A inputs with pull-ups, port B outputs 	// <-- EDIT HERE
+ */
+void expander_bus_init(void) {
+	static const uint8_t iodir[EXPANDER_PORTS] = {0xFF, 0x00};	// <-- EDIT HERE
+	static const uint8_t gppu[EXPANDER_PORTS] = {0xFF, 0x00};	// <-- EDIT HERE
+	
+	I2C_WRITE(EXPANDER_I2C, EXPANDER_ADDR, 0x00, iodir, EXPANDER_PORTS);	// IODIRA, <-- EDIT HERE
+	I2C_WRITE(EXPANDER_I2C, EXPANDER_ADDR, 0x0C, gppu, EXPANDER_PORTS);	// GPPUA, <-- EDIT HERE
+}
+
+
+
+/**
+ * @fn void expander_bus_read(uint8_t, uint8_t*, uint8_t)
+ * @brief Starts reading len consecutive registers, returns without waiting
+ * 
+ * @param reg (uint8_t) first register
+ * @param data (uint8_t*) filled by transfer, untouched until it completes
+ * @param len (uint8_t) amount of registers
+ * 
+ * @note Call expander_transfer_done() from transfer complete and error callbacks,
+ * at same or higher priority than the handler timer. From a lower priority or a thread,
+ * mask the handler timer interrupt around the call, it shares transfer state with the handler
+ */
+void expander_bus_read(uint8_t reg, uint8_t *data, uint8_t len) {
+	I2C_READ_DMA(EXPANDER_I2C, EXPANDER_ADDR, reg, data, len);	// <-- EDIT HERE
+}
+
+
+
+/**
+ * @fn void expander_bus_write(uint8_t, const uint8_t*, uint8_t)
+ * @brief Starts writing len consecutive registers, returns without waiting
+ * 
+ * @param reg (uint8_t) first register
+ * @param data (const uint8_t*) kept unchanged until transfer completes
+ * @param len (uint8_t) amount of registers
+ * 
+ * @note Call expander_transfer_done() from transfer complete and error callbacks,
+ * at same or higher priority than the handler timer. From a lower priority or a thread,
+ * mask the handler timer interrupt around the call, it shares transfer state with the handler
+ */
+void expander_bus_write(uint8_t reg, const uint8_t *data, uint8_t len) {
+	I2C_WRITE_DMA(EXPANDER_I2C, EXPANDER_ADDR, reg, data, len);	// <-- EDIT HERE
+}
+#endif
+
+
+
+#if defined(SWITCHES_USE) && !defined(USER_IO_CPP_DRIVER_USE)
 /**
  * @fn void btn_pins_init(void)
  * @brief Inits all switch-pins and applies internal pull-up // <-- EDIT HERE
@@ -61,7 +352,7 @@ enum switch_state switch_get_state(enum switch_id id) {
 
 
 
-#ifdef BTNS_USE
+#if defined(BTNS_USE) && !defined(USER_IO_CPP_DRIVER_USE)
 /**
  * @fn void btn_pins_init(void)
  * @brief Inits all button-pins and applies internal pull-up
@@ -102,13 +393,118 @@ enum btn_state btn_get_state(enum btn_id id) {
 
 
 
-#ifdef LEDS_USE
+#if defined(BTNS_USE) && defined(USER_IO_SPARSE_USE) && !defined(USER_IO_CPP_DRIVER_USE)
+/**
+ * @fn uint32_t btns_get_pressed(uint16_t)
+ * @brief Returns pressed buttons word * 32 to word * 32 + 31, bit n is button word * 32 + n
+ * 
+ * @param word (uint16_t) group of 32 buttons
+ * @return (uint32_t) pressed buttons
+ * 
+ * @note Called for every word each tick with USER_IO_SPARSE_USE, this template reads 32 pins per word
+ * so it costs as much as updating every button. Read whole input ports here instead, only pressed
+ * bits wake buttons 	// <-- EDIT HERE
+ */
+uint32_t btns_get_pressed(uint16_t word) {
+	uint32_t pressed = 0;
+	
+	for (uint8_t bit = 0; bit < 32; bit++) {
+		uint32_t id = ((uint32_t) word << 5) + bit;
+		
+		if ((id < BTNS_AMOUNT) && (btn_get_state((enum btn_id) id) == BTN_PRESSED)) {
+			pressed |= (uint32_t) 1U << bit;
+		}
+	}
+	return pressed;
+}
+#endif
+
+
+
+#ifdef BTN_LADDER_USE
+/**
+ * @fn void btn_ladder_adc_init(void)
+ * @brief Inits ADC channels used by resistor ladder buttons
+ * 
+ */
+void btn_ladder_adc_init(void) {
+	ADC_CONFIG(BTN_LADDER_ADC, BTN_LADDER0_CHANNEL);	// <-- EDIT HERE
+}
+
+
+
+/**
+ * @fn void btn_ladder_get_samples(uint16_t*)
+ * @brief Returns latest sample of every ladder channel, called once per tick
+ * 
+ * @param samples (uint16_t*) BTN_LADDER_CHANNELS samples to fill
+ * 
+ * @note Copy from a DMA'd sample buffer if ADC is running continuously
+ */
+void btn_ladder_get_samples(uint16_t *samples) {
+	samples[0] = ADC_READ(BTN_LADDER_ADC, BTN_LADDER0_CHANNEL);	// <-- EDIT HERE
+}
+#endif
+
+
+
+#ifdef ENCODERS_USE
+/**
+ * @fn void encoder_pins_init(void)
+ * @brief Inits all encoder-pins and applies internal pull-up
+ * 
+ */
+void encoder_pins_init(void) {
+	PIN_CONFIG(ENC0_A_PIN, INPUT_PULL_UP); 	// <-- EDIT HERE
+	PIN_CONFIG(ENC0_B_PIN, INPUT_PULL_UP); 	// <-- EDIT HERE
+}
+
+
+
+/**
+ * @fn uint8_t encoder_get_ab(enum encoder_id)
+ * @brief Returns both channels of specific encoder
+ * 
+ * @param id (enum encoder_id) encoder to read from
+ * @return (uint8_t) A in bit 1, B in bit 0
+ */
+uint8_t encoder_get_ab(enum encoder_id id) {
+	switch (id) {
+		case ENC0:
+			return (uint8_t) ((PIN_READ(ENC0_A_PIN) << 1) | PIN_READ(ENC0_B_PIN)); 	// <-- EDIT HERE
+			
+		default:
+			return 0;
+	}
+}
+#endif
+
+
+
+#if defined(LEDS_USE) && !defined(USER_IO_CPP_DRIVER_USE)
 /**
  * @fn void led_pins_init(void)
  * @brief Inits all LED-pins and turns them off
  * 
  */
 void led_pins_init(void) {
+#if defined(LED_MATRIX_USE) && defined(LED_MATRIX_CHARLIEPLEX)
+	for (uint8_t pin = 0; pin < LED_MATRIX_ROWS; pin++) {
+		PIN_LOW(led_matrix_pins[pin]);				// <-- EDIT HERE
+		PIN_CONFIG(led_matrix_pins[pin], INPUT);	// <-- EDIT HERE
+	}
+	led_matrix_outputs = 0;
+#elif defined(LED_MATRIX_USE)
+	for (uint8_t row = 0; row < LED_MATRIX_ROWS; row++) {
+		PIN_CONFIG(led_matrix_row_pins[row], OUTPUT);	// <-- EDIT HERE
+		PIN_LOW(led_matrix_row_pins[row]);				// <-- EDIT HERE
+	}
+	
+	for (uint8_t col = 0; col < LED_MATRIX_COLS; col++) {
+		PIN_CONFIG(led_matrix_col_pins[col], OUTPUT);	// <-- EDIT HERE
+		PIN_HIGH(led_matrix_col_pins[col]);				// <-- EDIT HERE
+	}
+#else
 	PIN_CONFIG(LED0_PIN, OUTPUT); 	// <-- EDIT HERE
 	PIN_CONFIG(LED1_PIN, OUTPUT); 	// <-- EDIT HERE
 	PIN_CONFIG(LED2_PIN, OUTPUT); 	// <-- EDIT HERE
@@ -116,6 +512,7 @@ void led_pins_init(void) {
 	PIN_LOW(LED0_PIN);				// <-- EDIT HERE
 	PIN_LOW(LED1_PIN);				// <-- EDIT HERE
 	PIN_LOW(LED2_PIN);				// <-- EDIT HERE
+#endif
 }
 
 
@@ -189,4 +586,99 @@ void led_driver_toggle(enum led_id id) {
 			break;
 	}
 }
-#endif
\ No newline at end of file
+#endif
+
+
+
+#ifdef LED_WAVEFORM_USE
+/**
+ * @fn void led_driver_waveform_start(const uint32_t*, uint16_t)
+ * @brief Starts playing out rendered LED words in a loop, one word per handler tick
+ * 
+ * @param words (const uint32_t*) bit n turns LEDn on, bit n + 16 turns LEDn off
+ * @param ticks (uint16_t) amount of words, words[0] is due on next tick
+ * 
+ * @note Words match the set/reset register of a port when LEDn is on pin n. Run DMA in
+ * circular mode and call led_waveform_half_done() from half transfer and transfer complete
+ * interrupts, a half is only rewritten after that. Called at init and after resume from sleep
+ */
+void led_driver_waveform_start(const uint32_t *words, uint16_t ticks) {
+	DMA_STOP();												// <-- EDIT HERE
+	DMA_START_CIRCULAR(words, &LED_PORT_BSRR, ticks);	// <-- EDIT HERE
+}
+#endif
+
+
+
+#ifdef LED_MATRIX_USE
+/**
+ * @fn void led_driver_matrix_row(uint8_t, uint32_t)
+ * @brief Drives one matrix row, LEDs of other rows are off
+ * 
+ * @param row (uint8_t) row to drive
+ * @param columns (uint32_t) bit n lights LED at column n
+ * 
+ * @note Rows source and columns sink here, pins are configured once in led_pins_init().
+ * Charlieplexed pins not driven are left floating
+ */
+void led_driver_matrix_row(uint8_t row, uint32_t columns) {
+#ifdef LED_MATRIX_CHARLIEPLEX
+	uint32_t outputs = columns? (columns | ((uint32_t) 1U << row)) : 0;
+	uint32_t changed = outputs ^ led_matrix_outputs;
+	
+	// Sink all driven pins first, avoids ghosting while switching rows
+	for (uint8_t pin = 0; pin < LED_MATRIX_ROWS; pin++) {
+		if (led_matrix_outputs & ((uint32_t) 1U << pin)) {
+			PIN_LOW(led_matrix_pins[pin]);	// <-- EDIT HERE
+		}
+	}
+	
+	// Floating needs a mode change, only pins joining or leaving the driven set are reconfigured
+	for (uint8_t pin = 0; pin < LED_MATRIX_ROWS; pin++) {
+		if (changed & ((uint32_t) 1U << pin)) {
+			PIN_CONFIG(led_matrix_pins[pin], (outputs & ((uint32_t) 1U << pin))? OUTPUT : INPUT);	// <-- EDIT HERE
+		}
+	}
+	led_matrix_outputs = outputs;
+	
+	if (columns) {
+		PIN_HIGH(led_matrix_pins[row]);	// <-- EDIT HERE
+	}
+#else
+	// Blank all rows first, avoids ghosting while switching columns
+	for (uint8_t r = 0; r < LED_MATRIX_ROWS; r++) {
+		PIN_LOW(led_matrix_row_pins[r]);	// <-- EDIT HERE
+	}
+	
+	for (uint8_t col = 0; col < LED_MATRIX_COLS; col++) {
+		if (columns & ((uint32_t) 1U << col)) {
+			PIN_LOW(led_matrix_col_pins[col]);	// <-- EDIT HERE
+		} else {
+			PIN_HIGH(led_matrix_col_pins[col]);	// <-- EDIT HERE
+		}
+	}
+	
+	PIN_HIGH(led_matrix_row_pins[row]);	// <-- EDIT HERE
+#endif
+}
+#endif
+
+
+
+#ifdef LED_RGB_USE
+/**
+ * @fn void led_driver_rgb_transfer(const uint8_t*, uint16_t)
+ * @brief Sends encoded LED chain, only called when a pixel changed
+ * 
+ * @param data (const uint8_t*) encoded chain, 4 bits per color bit, GRB order
+ * @param len (uint16_t) amount of bytes
+ * 
+ * @note Send MSB first over SPI at 3.2 MHz with MOSI idle low. Call led_rgb_transfer_done()
+ * from transfer complete and error callbacks, buffer isn't touched until then. Next frame
+ * starts on a later tick, which keeps the line low long enough to latch
+ */
+void led_driver_rgb_transfer(const uint8_t *data, uint16_t len) {
+	SPI_DMA_SEND(LED_RGB_SPI, data, len);	// <-- EDIT HERE
+}
+#endif
+#endif
@@ -0,0 +1,683 @@
+/**
+ * 
+ * @file user_io_driver_linux.c
+ * @version 1.1.0
+ * 
+ * ------------------------------
+ * 
+ * @author https://github.com/AJ747
+ * @date Jul 12, 2025
+ * 
+ * ------------------------------
+ * 
+ * @brief Linux userspace driver-layer source, replaces pin drivers in user_io_driver.c
+ * 
+ */
+
+
+
+//---------------------------//
+// Include begin
+//---------------------------//
+// pipe2(), clock_gettime() and ioctl() with -std=c99, before any include
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "user_io.h"
+#include "user_io_driver.h"
+#include "user_io_linux.h"
+
+#ifdef USER_IO_LINUX_USE
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#ifndef USER_IO_LINUX_SIM_PINS
+#include <linux/gpio.h>
+#endif
+#endif
+//---------------------------//
+// Include end
+//---------------------------//
+
+
+
+#ifdef USER_IO_LINUX_USE
+//---------------------------//
+// Define begin
+//---------------------------//
+#if defined(LED_WAVEFORM_USE) || defined(LED_RGB_USE) || defined(LED_MATRIX_USE) || defined(BTN_LADDER_USE) || defined(ENCODERS_USE) || defined(USER_IO_EXPANDER_USE)
+#error "Linux port drives GPIO switches, buttons and LEDs only"
+#endif
+
+#define LINUX_LINES_MAX 64
+#define LINUX_EVENTS_MAX 16
+
+// Entries in a {a, b, ...} line list as a number usable in #if, 65 means more than 64
+#define LINUX_LINES_AMOUNT(lines) LINUX_LINES_COUNT(lines, 65, 64, 63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49, 48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LINUX_LINES_COUNT(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, _33, _34, _35, _36, _37, _38, _39, _40, _41, _42, _43, _44, _45, _46, _47, _48, _49, _50, _51, _52, _53, _54, _55, _56, _57, _58, _59, _60, _61, _62, _63, _64, _65, n, ...) n
+
+#ifdef SWITCHES_USE
+#define LINUX_SWITCHES_AMOUNT LINUX_LINES_AMOUNT(USER_IO_LINUX_SWITCH_LINES)
+#else
+#define LINUX_SWITCHES_AMOUNT 0
+#endif
+
+#ifdef BTNS_USE
+#define LINUX_BTNS_AMOUNT LINUX_LINES_AMOUNT(USER_IO_LINUX_BTN_LINES)
+#if LINUX_BTNS_AMOUNT != BTNS_AMOUNT
+#error "USER_IO_LINUX_BTN_LINES needs one line per button, BTNS_AMOUNT entries"
+#endif
+#else
+#define LINUX_BTNS_AMOUNT 0
+#endif
+
+// Switch and button lines share one request
+#if (LINUX_SWITCHES_AMOUNT + LINUX_BTNS_AMOUNT) > LINUX_LINES_MAX
+#error "Linux port supports up to 64 switches and buttons combined"
+#endif
+
+#if defined(LEDS_USE) && (LEDS_AMOUNT > LINUX_LINES_MAX)
+#error "Linux port supports up to 64 LEDs"
+#endif
+
+// Bit n set for LEDn, shifting by 64 is undefined
+#if defined(LEDS_USE) && (LEDS_AMOUNT < LINUX_LINES_MAX)
+#define LINUX_LEDS_MASK ((1ULL << LEDS_AMOUNT) - 1U)
+#else
+#define LINUX_LEDS_MASK (~0ULL)
+#endif
+
+#if defined(LEDS_USE) && (LINUX_LINES_AMOUNT(USER_IO_LINUX_LED_LINES) != LEDS_AMOUNT)
+#error "USER_IO_LINUX_LED_LINES needs one line per LED, LEDS_AMOUNT entries"
+#endif
+//---------------------------//
+// Define end
+//---------------------------//
+
+
+
+//---------------------------//
+// Struct begin
+//---------------------------//
+#ifdef USER_IO_LINUX_SIM_PINS
+struct linux_sim_msg {
+	uint32_t line;
+	uint32_t active;
+};
+#endif
+//---------------------------//
+// Struct end
+//---------------------------//
+
+
+
+//---------------------------//
+// Prototypes begin
+//---------------------------//
+static void linux_inputs_request(void);
+static void linux_inputs_read(void);
+static int linux_input_index(uint32_t line);
+static void linux_leds_flush(void);
+//---------------------------//
+// Prototypes end
+//---------------------------//
+
+
+
+//---------------------------//
+// Variable begin
+//---------------------------//
+#ifdef SWITCHES_USE
+static const uint32_t linux_switch_line[] = USER_IO_LINUX_SWITCH_LINES;
+#endif
+
+#ifdef BTNS_USE
+static const uint32_t linux_btn_line[] = USER_IO_LINUX_BTN_LINES;
+#endif
+
+#ifdef LEDS_USE
+static const uint32_t linux_led_line[LEDS_AMOUNT] = USER_IO_LINUX_LED_LINES;
+static uint64_t linux_led_bits = 0;
+static uint64_t linux_led_dirty = 0;
+#endif
+
+#if defined(LEDS_USE) && !defined(USER_IO_LINUX_SIM_PINS)
+static int linux_output_fd = -1;
+#endif
+
+// Switches first, then buttons
+static uint32_t linux_input_line[LINUX_LINES_MAX];
+static bool linux_input_state[LINUX_LINES_MAX];
+static uint8_t linux_inputs_amount = 0;
+static int linux_input_fd = -1;
+
+static int linux_epoll_fd = -1;
+static int linux_timer_fd = -1;
+static bool linux_pins_failed = false;
+
+#ifdef USER_IO_LINUX_SIM_PINS
+static int linux_sim_pipe[2] = {-1, -1};
+static uint32_t linux_sim_writes = 0;
+#endif
+//---------------------------//
+// Variable end
+//---------------------------//
+
+
+
+/**
+ * @fn int user_io_linux_init(void)
+ * @brief Starts handler timer and registers inputs in one epoll set, call after user_io_init()
+ * 
+ * @return (int) 0 on success, -1 if pins, timer or epoll could not be set up
+ */
+int user_io_linux_init(void) {
+	struct itimerspec period;
+	struct epoll_event event;
+
+	if (linux_pins_failed) {
+		return -1;
+	}
+
+	linux_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	linux_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if ((linux_epoll_fd < 0) || (linux_timer_fd < 0)) {
+		return -1;
+	}
+
+	// Periodic kernel timer, ticks don't drift with handler run time
+	period.it_interval.tv_sec = USER_IO_HANDLER_PERIOD_MS / 1000;
+	period.it_interval.tv_nsec = (long) (USER_IO_HANDLER_PERIOD_MS % 1000) * 1000000L;
+	period.it_value = period.it_interval;
+	if (timerfd_settime(linux_timer_fd, 0, &period, NULL) < 0) {
+		return -1;
+	}
+
+	event.events = EPOLLIN;
+	event.data.fd = linux_timer_fd;
+	if (epoll_ctl(linux_epoll_fd, EPOLL_CTL_ADD, linux_timer_fd, &event) < 0) {
+		return -1;
+	}
+
+	if (linux_input_fd >= 0) {
+		event.events = EPOLLIN;
+		event.data.fd = linux_input_fd;
+		if (epoll_ctl(linux_epoll_fd, EPOLL_CTL_ADD, linux_input_fd, &event) < 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+
+
+/**
+ * @fn int user_io_linux_poll(int)
+ * @brief Waits for input changes or timer ticks, runs handler once per elapsed tick
+ * 
+ * @param timeout_ms (int) max time to wait, -1 to wait until next tick
+ * @return (int) amount of ticks handled, -1 on error
+ * 
+ * @note LED changes are written once after all ticks are handled
+ */
+int user_io_linux_poll(int timeout_ms) {
+	struct epoll_event events[2];
+	bool timer_ready = false;
+	int ticks = 0;
+
+	int ready = epoll_wait(linux_epoll_fd, events, 2, timeout_ms);
+	if (ready < 0) {
+		return (errno == EINTR)? 0 : -1;
+	}
+
+	// Inputs first, so handler samples latest states
+	for (int i = 0; i < ready; i++) {
+		if (events[i].data.fd == linux_input_fd) {
+			linux_inputs_read();
+		} else if (events[i].data.fd == linux_timer_fd) {
+			timer_ready = true;
+		}
+	}
+
+	if (timer_ready) {
+		uint64_t expirations = 0;
+
+		if (read(linux_timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+			// Late wake-ups catch up in one call
+			user_io_handler_elapsed((uint32_t) expirations);
+			ticks = (int) expirations;
+		}
+	}
+
+	linux_leds_flush();
+
+	return ticks;
+}
+
+
+
+/**
+ * @fn int user_io_linux_fd(void)
+ * @brief Returns epoll fd, poll it from an outer event loop and call user_io_linux_poll(0) when readable
+ * 
+ * @return (int)
+ */
+int user_io_linux_fd(void) {
+	return linux_epoll_fd;
+}
+
+
+
+#ifdef SWITCHES_USE
+/**
+ * @fn void switch_pins_init(void)
+ * @brief Requests all input lines with edge events
+ * 
+ */
+void switch_pins_init(void) {
+	linux_inputs_request();
+}
+
+
+
+/**
+ * @fn enum switch_state switch_get_state(enum switch_id)
+ * @brief Returns state of switch from last input event
+ * 
+ * @param id (enum switch_id) switch id
+ * @return (enum switch_state) SWITCH_OFF or SWITCH_ON
+ */
+enum switch_state switch_get_state(enum switch_id id) {
+	return linux_input_state[id]? SWITCH_ON : SWITCH_OFF;
+}
+#endif
+
+
+
+#ifdef BTNS_USE
+/**
+ * @fn void btn_pins_init(void)
+ * @brief Requests all input lines with edge events
+ * 
+ */
+void btn_pins_init(void) {
+	linux_inputs_request();
+}
+
+
+
+/**
+ * @fn enum btn_state btn_get_state(enum btn_id)
+ * @brief Returns state of specific button from last input event
+ * 
+ * @param id (enum btn_id) button to read from
+ * @return (enum btn_state) depressed (0) or pressed (1)
+ */
+enum btn_state btn_get_state(enum btn_id id) {
+	return linux_input_state[LINUX_SWITCHES_AMOUNT + id]? BTN_PRESSED : BTN_DEPRESSED;
+}
+#endif
+
+
+
+#if defined(BTNS_USE) && defined(USER_IO_SPARSE_USE)
+/**
+ * @fn uint32_t btns_get_pressed(uint16_t)
+ * @brief Returns pressed buttons word * 32 to word * 32 + 31 from last input events
+ * 
+ * @param word (uint16_t) group of 32 buttons
+ * @return (uint32_t) pressed buttons, bit n is button word * 32 + n
+ */
+uint32_t btns_get_pressed(uint16_t word) {
+	uint32_t pressed = 0;
+	
+	for (uint8_t bit = 0; bit < 32; bit++) {
+		uint32_t id = ((uint32_t) word << 5) + bit;
+		
+		if ((id < LINUX_BTNS_AMOUNT) && linux_input_state[LINUX_SWITCHES_AMOUNT + id]) {
+			pressed |= 1UL << bit;
+		}
+	}
+	return pressed;
+}
+#endif
+
+
+
+#ifdef LEDS_USE
+/**
+ * @fn void led_pins_init(void)
+ * @brief Requests all LED lines as outputs, turned off
+ * 
+ * @note Lines held from an earlier call are reused and turned off at end of tick
+ */
+void led_pins_init(void) {
+	linux_led_bits = 0;
+	linux_led_dirty = 0;
+
+#ifndef USER_IO_LINUX_SIM_PINS
+	struct gpio_v2_line_request request;
+
+	// Lines already requested are kept, requesting them again fails as busy
+	if (linux_output_fd >= 0) {
+		linux_led_dirty = LINUX_LEDS_MASK;
+		return;
+	}
+
+	int chip_fd = open(USER_IO_LINUX_GPIOCHIP, O_RDONLY | O_CLOEXEC);
+	if (chip_fd < 0) {
+		linux_pins_failed = true;
+		return;
+	}
+
+	memset(&request, 0, sizeof(request));
+	for (uint8_t id = 0; id < LEDS_AMOUNT; id++) {
+		request.offsets[id] = linux_led_line[id];
+	}
+	strncpy(request.consumer, "user_io", sizeof(request.consumer) - 1);
+	request.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+	request.num_lines = LEDS_AMOUNT;
+
+	if (ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &request) < 0) {
+		linux_pins_failed = true;
+	} else {
+		linux_output_fd = request.fd;
+	}
+
+	close(chip_fd);
+#endif
+}
+
+
+
+/**
+ * @fn void led_driver_on(enum led_id)
+ * @brief Turns on specific LED, written at end of tick
+ * 
+ * @param id (enum led_id)
+ */
+void led_driver_on(enum led_id id) {
+	linux_led_bits |= (1ULL << id);
+	linux_led_dirty |= (1ULL << id);
+}
+
+
+
+/**
+ * @fn void led_driver_off(enum led_id)
+ * @brief Turns off specific LED, written at end of tick
+ * 
+ * @param id (enum led_id) LED to turn off
+ */
+void led_driver_off(enum led_id id) {
+	linux_led_bits &= ~(1ULL << id);
+	linux_led_dirty |= (1ULL << id);
+}
+
+
+
+/**
+ * @fn void led_driver_toggle(enum led_id)
+ * @brief Toggles specific LED, written at end of tick
+ * 
+ * @param id (enum led_id) LED to toggle
+ */
+void led_driver_toggle(enum led_id id) {
+	linux_led_bits ^= (1ULL << id);
+	linux_led_dirty |= (1ULL << id);
+}
+#endif
+
+
+
+#if defined(USER_IO_OVERRUN_USE) || defined(BTN_TIMESTAMPS_USE)
+/**
+ * @fn uint32_t user_io_timestamp_us(void)
+ * @brief Returns monotonic timestamp in us, used to measure the handler and button edges
+ * 
+ * @return (uint32_t)
+ */
+uint32_t user_io_timestamp_us(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint32_t) (((uint64_t) now.tv_sec * 1000000U) + ((uint64_t) now.tv_nsec / 1000U));
+}
+#endif
+
+
+
+#ifdef USER_IO_RETAIN_USE
+/**
+ * @fn void user_io_pins_resume(void)
+ * @brief Requests lines again, they don't outlive the process. Lines still held are kept
+ * 
+ */
+void user_io_pins_resume(void) {
+#ifdef SWITCHES_USE
+	switch_pins_init();
+#endif
+#ifdef BTNS_USE
+	btn_pins_init();
+#endif
+#ifdef LEDS_USE
+	led_pins_init();
+#endif
+}
+#endif
+
+
+
+#ifdef USER_IO_LINUX_SIM_PINS
+/**
+ * @fn void user_io_linux_sim_input(uint32_t, bool)
+ * @brief Changes a simulated input line, delivered through the epoll set like a GPIO edge event
+ * 
+ * @param line (uint32_t) line offset from USER_IO_LINUX_SWITCH_LINES or USER_IO_LINUX_BTN_LINES
+ * @param active (bool) true if pressed or on
+ */
+void user_io_linux_sim_input(uint32_t line, bool active) {
+	struct linux_sim_msg msg = {line, active};
+
+	if (write(linux_sim_pipe[1], &msg, sizeof(msg)) != sizeof(msg)) {
+		return;
+	}
+}
+
+
+
+/**
+ * @fn bool user_io_linux_sim_output(uint32_t)
+ * @brief Returns last written state of a simulated LED line
+ * 
+ * @param line (uint32_t) line offset from USER_IO_LINUX_LED_LINES
+ * @return (bool) true if on
+ */
+bool user_io_linux_sim_output(uint32_t line) {
+#ifdef LEDS_USE
+	for (uint8_t id = 0; id < LEDS_AMOUNT; id++) {
+		if (linux_led_line[id] == line) {
+			return (linux_led_bits >> id) & 1U;
+		}
+	}
+#endif
+	(void) line;
+	return false;
+}
+
+
+
+/**
+ * @fn uint32_t user_io_linux_sim_output_writes(void)
+ * @brief Returns amount of batched LED writes done so far
+ * 
+ * @return (uint32_t)
+ */
+uint32_t user_io_linux_sim_output_writes(void) {
+	return linux_sim_writes;
+}
+#endif
+
+
+
+/**
+ * @fn void linux_inputs_request(void)
+ * @brief Requests switch and button lines once, as one pollable fd
+ * 
+ */
+static void linux_inputs_request(void) {
+	if ((linux_input_fd >= 0) || linux_pins_failed) {
+		return;
+	}
+
+	linux_inputs_amount = 0;
+#ifdef SWITCHES_USE
+	for (uint8_t i = 0; i < LINUX_SWITCHES_AMOUNT; i++) {
+		linux_input_line[linux_inputs_amount++] = linux_switch_line[i];
+	}
+#endif
+#ifdef BTNS_USE
+	for (uint8_t i = 0; i < LINUX_BTNS_AMOUNT; i++) {
+		linux_input_line[linux_inputs_amount++] = linux_btn_line[i];
+	}
+#endif
+
+	for (uint8_t i = 0; i < linux_inputs_amount; i++) {
+		linux_input_state[i] = false;
+	}
+
+#ifdef USER_IO_LINUX_SIM_PINS
+	if (pipe2(linux_sim_pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+		linux_pins_failed = true;
+		return;
+	}
+	linux_input_fd = linux_sim_pipe[0];
+#else
+	struct gpio_v2_line_request request;
+	struct gpio_v2_line_values values;
+
+	int chip_fd = open(USER_IO_LINUX_GPIOCHIP, O_RDONLY | O_CLOEXEC);
+	if (chip_fd < 0) {
+		linux_pins_failed = true;
+		return;
+	}
+
+	memset(&request, 0, sizeof(request));
+	for (uint8_t i = 0; i < linux_inputs_amount; i++) {
+		request.offsets[i] = linux_input_line[i];
+	}
+	strncpy(request.consumer, "user_io", sizeof(request.consumer) - 1);
+	request.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+#ifdef USER_IO_LINUX_INPUT_ACTIVE_LOW
+	request.config.flags |= GPIO_V2_LINE_FLAG_ACTIVE_LOW;
+#endif
+#ifdef USER_IO_LINUX_INPUT_PULL_UP
+	request.config.flags |= GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+#endif
+	request.num_lines = linux_inputs_amount;
+
+	if (ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &request) < 0) {
+		linux_pins_failed = true;
+		close(chip_fd);
+		return;
+	}
+	close(chip_fd);
+	linux_input_fd = request.fd;
+
+	// Initial states, later changes arrive as edge events
+	memset(&values, 0, sizeof(values));
+	values.mask = (linux_inputs_amount == LINUX_LINES_MAX)? ~0ULL : ((1ULL << linux_inputs_amount) - 1);
+	if (ioctl(linux_input_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) == 0) {
+		for (uint8_t i = 0; i < linux_inputs_amount; i++) {
+			linux_input_state[i] = (values.bits >> i) & 1U;
+		}
+	}
+#endif
+}
+
+
+
+/**
+ * @fn void linux_inputs_read(void)
+ * @brief Drains pending input events and updates cached input states
+ * 
+ */
+static void linux_inputs_read(void) {
+#ifdef USER_IO_LINUX_SIM_PINS
+	struct linux_sim_msg msgs[LINUX_EVENTS_MAX];
+#else
+	struct gpio_v2_line_event msgs[LINUX_EVENTS_MAX];
+#endif
+	ssize_t len;
+
+	while ((len = read(linux_input_fd, msgs, sizeof(msgs))) > 0) {
+		for (size_t i = 0; i < ((size_t) len / sizeof(msgs[0])); i++) {
+#ifdef USER_IO_LINUX_SIM_PINS
+			int index = linux_input_index(msgs[i].line);
+			bool active = msgs[i].active;
+#else
+			int index = linux_input_index(msgs[i].offset);
+			bool active = (msgs[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE);
+#endif
+			if (index >= 0) {
+				linux_input_state[index] = active;
+			}
+		}
+	}
+}
+
+
+
+/**
+ * @fn int linux_input_index(uint32_t)
+ * @brief Returns input index of line offset
+ * 
+ * @param line (uint32_t) line offset
+ * @return (int) index, -1 if not an input line
+ */
+static int linux_input_index(uint32_t line) {
+	for (uint8_t i = 0; i < linux_inputs_amount; i++) {
+		if (linux_input_line[i] == line) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+
+
+/**
+ * @fn void linux_leds_flush(void)
+ * @brief Writes all LEDs changed since last flush in one transaction
+ * 
+ */
+static void linux_leds_flush(void) {
+#ifdef LEDS_USE
+	if (!linux_led_dirty) {
+		return;
+	}
+
+#ifdef USER_IO_LINUX_SIM_PINS
+	linux_sim_writes++;
+#else
+	struct gpio_v2_line_values values;
+
+	values.bits = linux_led_bits;
+	values.mask = linux_led_dirty;
+	if (ioctl(linux_output_fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0) {
+		return;
+	}
+#endif
+
+	linux_led_dirty = 0;
+#endif
+}
+#endif